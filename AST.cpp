@@ -2,170 +2,112 @@
 
 //------------------------------------------------------------------------------------
 
-std::string typeToString(const Type t)
-{
-   switch (t) {
-      case Type::VOID:
-         return "void";
-      case Type::BOOL:
-         return "boolean";
-      case Type::INT:
-         return "int";
-      default:
-         return "_ERROR_"; // shouldn't ever print
-   }
+SymbolTable& SymbolTable::global()
+{
+   static SymbolTable symbolTable;
+   return symbolTable;
 }
 
 //------------------------------------------------------------------------------------
 
-std::string infixOpToString(const InfixOperator infixOperator)
+int SymbolTable::intern(const std::string& identifier)
 {
-   switch (infixOperator) {
-      case InfixOperator::LESS_EQUALS:
-         return "<=";
-      case InfixOperator::EQUALS:
-         return "==";
-      case InfixOperator::PLUS:
-         return "+";
-      case InfixOperator::TIMES:
-         return "*";
-      case InfixOperator::ASSIGNMENT:
-         return "=";
-      default:
-         return "_ERROR_";
-   }
+   auto result = m_slots.find(identifier);
+   if (result != m_slots.end()) return result->second;
+   m_identifiers.push_back(identifier);
+   m_slots.emplace(identifier, m_identifiers.size() - 1);
+   return m_identifiers.size() - 1;
 }
 
 //------------------------------------------------------------------------------------
 
-std::string postfixOpToString(const PostfixOperator postfixOperator)
+int SymbolTable::find(const std::string& identifier) const
 {
-   switch (postfixOperator) {
-      case PostfixOperator::INCREMENT:
-         return "++";
-      case PostfixOperator::DECREMENT:
-         return "--";
-      default: 
-         return "_ERROR_";
-   }
+   auto result = m_slots.find(identifier);
+   return result == m_slots.end() ? -1 : result->second;
 }
 
 //------------------------------------------------------------------------------------
 
-std::string infixOpToStringJs(const InfixOperator infixOperator)
+void Printer::printIndents() const
 {
-   switch (infixOperator) {
-      case InfixOperator::LESS_EQUALS:
-         return "<=";
-      case InfixOperator::EQUALS:
-         return "===";
-      case InfixOperator::PLUS:
-         return "+";
-      case InfixOperator::TIMES:
-         return "*";
-      case InfixOperator::ASSIGNMENT:
-         return "=";
-      default:
-         return "_ERROR_";
-   }
+   for (int i=0; i<m_indents; ++i)
+      *m_out << m_indentType;
 }
 
 //------------------------------------------------------------------------------------
 
-// 3 languages, 3 ways to write equality
-std::string infixOpToStringScm(const InfixOperator infixOperator)
+void Printer::printIntVector(const std::vector<int>& v) const
 {
-   switch (infixOperator) {
-      case InfixOperator::LESS_EQUALS:
-         return "<=";
-      case InfixOperator::EQUALS:
-         return "=";
-      case InfixOperator::PLUS:
-         return "+";
-      case InfixOperator::TIMES:
-         return "*";
-      case InfixOperator::ASSIGNMENT:
-         return "=";
-      default:
-         return "_ERROR_";
-   }
+   if (v.empty()) return;
+   if (v.size() > 1)
+      for (int i=0; i < static_cast<int>(v.size())-1; ++i)
+         *m_out << v.at(i) << ',';
+   *m_out << v.back();
 }
 
 //------------------------------------------------------------------------------------
 
-std::string postfixOpToStringScm(const PostfixOperator postfixOperator)
+void Printer::printIntVector(const int* v, unsigned size) const
 {
-   switch (postfixOperator) {
-      case PostfixOperator::INCREMENT:
-         return "+";
-      case PostfixOperator::DECREMENT:
-         return "-";
-      default: 
-         return "_ERROR_";
+   for (unsigned i=0; i<size; ++i) {
+      if (i > 0) *m_out << ',';
+      *m_out << v[i];
    }
 }
-//------------------------------------------------------------------------------------
-
-void Printer::printIndents() const
-{
-   for (int i=0; i<m_indents; ++i)
-      *m_os << m_indentType;
-}
 
 //------------------------------------------------------------------------------------
 
-void Printer::printIntVector(const std::vector<int>& v) const
+void AssertBlock::reserve(unsigned numberRows)
 {
-   if (v.empty()) return;
-   if (v.size() > 1)
-      for (int i=0; i < static_cast<int>(v.size())-1; ++i)
-         *m_os << v.at(i) << ',';
-   *m_os << v.back();
+   m_args.reserve(numberRows * m_arity);
+   m_results.reserve(numberRows);
 }
 
 //------------------------------------------------------------------------------------
 
-TesterBoilerplate::~TesterBoilerplate()
-{ 
-   for (AssertStatement* as : m_asserts) if (as) delete as; 
+void AssertBlock::add(const int* args, int result)
+{
+   m_args.insert(m_args.end(), args, args + m_arity);
+   m_results.push_back(result);
 }
 
 //------------------------------------------------------------------------------------
 
 MethodDeclaration::~MethodDeclaration()
 {
-   if (m_body) delete m_body;
+   release(m_body);
 }
 
 //------------------------------------------------------------------------------------
 
 VarDeclStatement::~VarDeclStatement() 
 { 
-   for (VarDeclFragment* vd : m_varDecls) delete vd; 
+   for (VarDeclFragment* vd : m_varDecls) release(vd); 
 }
 
 //------------------------------------------------------------------------------------
 
 AssignmentStatement::~AssignmentStatement()
 {
-   if (m_name) delete m_name;
-   if (m_expr) delete m_expr;
+   release(m_name);
+   release(m_expr);
 }
 
 //------------------------------------------------------------------------------------
 
 IfStatement::~IfStatement()
 {
-   if (m_expr) delete m_expr;
-   if (m_thenStmt) delete m_thenStmt;
-   if (m_elseStmt) delete m_elseStmt;
+   release(m_expr);
+   release(m_thenStmt);
+   release(m_elseStmt);
 }
 
 //------------------------------------------------------------------------------------
 
 void IfStatement::setExpression(Expression* expression)
 {
-   if (m_expr) delete m_expr;
+   release(m_expr);
    m_expr = expression;
 }
 
@@ -173,7 +115,7 @@ void IfStatement::setExpression(Expression* expression)
 
 void IfStatement::setThenStatement(Statement* statement)
 {
-   if (m_thenStmt) delete m_thenStmt;
+   release(m_thenStmt);
    m_thenStmt = statement;
 }
 
@@ -181,7 +123,7 @@ void IfStatement::setThenStatement(Statement* statement)
 
 void IfStatement::setElseStatement(Statement* statement)
 {
-   if (m_elseStmt) delete m_elseStmt;
+   release(m_elseStmt);
    m_elseStmt = statement;
 }
 
@@ -189,24 +131,32 @@ void IfStatement::setElseStatement(Statement* statement)
 
 ForStatement::~ForStatement()
 {
-   if (!m_forInits.empty()) for (VarDeclFragment* vdf : m_forInits) delete vdf;
-   if (m_expr) delete m_expr;
-   if (m_body) delete m_body;
-   if (!m_updaters.empty()) for (Expression* e : m_updaters) delete e;
+   for (VarDeclFragment* vdf : m_forInits) release(vdf);
+   release(m_expr);
+   release(m_body);
+   for (Expression* e : m_updaters) release(e);
 }
 //------------------------------------------------------------------------------------
 
+VarDeclFragment::~VarDeclFragment()
+{
+   release(m_leftHand);
+   release(m_rightHand);
+}
+
+//------------------------------------------------------------------------------------
+
 InfixExpression::~InfixExpression()
 {
-   if (m_leftHand) delete m_leftHand;
-   if (m_rightHand) delete m_rightHand;
+   release(m_leftHand);
+   release(m_rightHand);
 }
 
 //------------------------------------------------------------------------------------
 
 void InfixExpression::setLeftOperand(Expression* expression)
 {
-   if (m_leftHand) delete m_leftHand;
+   release(m_leftHand);
    m_leftHand = expression;
 }
 
@@ -214,7 +164,7 @@ void InfixExpression::setLeftOperand(Expression* expression)
 
 void InfixExpression::setRightOperand(Expression* expression)
 {
-   if (m_rightHand) delete m_rightHand;
+   release(m_rightHand);
    m_rightHand = expression;
 }
 
@@ -245,9 +195,14 @@ void writeToFile(const boost::filesystem::path& path, const std::string& fileNam
 
    bfs::path filePath{bfs::path(path / fileName)};
    if (!bfs::exists(filePath)) {
+      // The printer's own sink keeps its buffer from file to file, so once it
+      // has grown to fit the largest file printing doesn't allocate
       std::ofstream outFileStream{filePath.c_str()};
       printer->setOutStream(outFileStream);
-      node->accept(printer);
+      // A program is printed by filling in a template of its shape
+      if (node->getKind() == NodeKind::BOILERPLATE)
+         printer->printByTemplate(static_cast<Boilerplate*>(node));
+      else node->accept(printer);
       printer->setOutStream(std::cout);
    }
 }
@@ -272,7 +227,7 @@ void createReturnBlocks(const std::vector<std::string>& returnValueStrings,
    // Note that created NumberLiterals on heap shouldn't be deleted, since they're
    // still pointed to by the Block*s' child pointers.
    for (const std::string& s : returnValueStrings) {
-      returnNumbers.push_back(new NumberLiteral{s});
+      returnNumbers.push_back(NodeFactory::global().number(std::stoi(s)));
       returnStatements.push_back(new ReturnStatement{returnNumbers.back()});
       returnBlocks.push_back(new Block);
       returnBlocks.back()->addStatement(returnStatements.back());
@@ -288,11 +243,12 @@ void createInfixExpressions(const std::vector<std::string>& names,
    if (names.size() != numbers.size()) throw BadSize{};
    std::vector<Name*> infixVariables;
    std::vector<NumberLiteral*> infixNumbers;
+   NodeFactory& nodes = NodeFactory::global();
    for (unsigned i=0; i<names.size(); ++i) {
-      infixVariables.push_back(new Name{names.at(i)});
-      infixNumbers.push_back(new NumberLiteral{numbers.at(i)});
-      infixExpressions.push_back(new InfixExpression{infixVariables.back(),
-            InfixOperator::LESS_EQUALS, infixNumbers.back()});
+      infixVariables.push_back(nodes.name(names.at(i)));
+      infixNumbers.push_back(nodes.number(std::stoi(numbers.at(i))));
+      infixExpressions.push_back(nodes.infix(infixVariables.back(),
+            InfixOperator::LESS_EQUALS, infixNumbers.back()));
    }
 }
 
@@ -426,19 +382,33 @@ void printAssert_js(const boost::filesystem::path& assertPath)
    bfs::path filePath{bfs::path(assertPath / "assert.js")};
    if (!bfs::exists(filePath)) {
       std::ofstream outFileStream{filePath.c_str()};
-      outFileStream << "function assert(condition, message) {" << std::endl;
-      outFileStream << "\tif (!condition) {" << std::endl;
-      outFileStream << "\t\tthrow {" << std::endl;
-      outFileStream << "\t\t\tname: 'AssertError'," << std::endl;
-      outFileStream << "\t\t\tmessage: message" << std::endl;
-      outFileStream << "\t\t};" << std::endl;
-      outFileStream << "\t}" << std::endl;
-      outFileStream << '}' << std::endl;
+      outFileStream << "function assert(condition, message) {" << '\n';
+      outFileStream << "\tif (!condition) {" << '\n';
+      outFileStream << "\t\tthrow {" << '\n';
+      outFileStream << "\t\t\tname: 'AssertError'," << '\n';
+      outFileStream << "\t\t\tmessage: message" << '\n';
+      outFileStream << "\t\t};" << '\n';
+      outFileStream << "\t}" << '\n';
+      outFileStream << '}' << '\n';
    }
 }
 
 //------------------------------------------------------------------------------------
 
+void JavaScript::printSupport(const boost::filesystem::path& languagePath)
+{
+   printAssert_js(languagePath);
+}
+
+//------------------------------------------------------------------------------------
+
+void Scheme::printSupport(const boost::filesystem::path& languagePath)
+{
+   printAssert_scm(languagePath);
+}
+
+//------------------------------------------------------------------------------------
+
 void printAssert_scm(const boost::filesystem::path& assertPath)
 {
    namespace bfs = boost::filesystem;
@@ -447,66 +417,67 @@ void printAssert_scm(const boost::filesystem::path& assertPath)
    bfs::path filePath{bfs::path(assertPath / "assert.scm")};
    if (!bfs::exists(filePath)) {
       std::ofstream outFileStream{filePath.c_str()};
-      outFileStream << "(define (assert msg b)" << std::endl 
-         << "\t(if (not b)" << std::endl
-         << "\t\t(begin" << std::endl
-         << "\t\t\t(print msg \"\\n\")" << std::endl
-         << "\t\t\t#f)" << std::endl
-         << "\t\t#t))" << std::endl;
+      outFileStream << "(define (assert msg b)" << '\n' 
+         << "\t(if (not b)" << '\n'
+         << "\t\t(begin" << '\n'
+         << "\t\t\t(print msg \"\\n\")" << '\n'
+         << "\t\t\t#f)" << '\n'
+         << "\t\t#t))" << '\n';
    }
 }
 //------------------------------------------------------------------------------------
 
-void printA1A2(Printer* myPrinter, const std::string& studentNumber, 
-      const std::string& language)
+template <typename Language> 
+void printA1A2(Printer* myPrinter, const std::string& studentNumber)
 {
       namespace bfs = boost::filesystem;
+      const std::string language{Language::name()};
       makeDirectories(studentNumber, language);
       bfs::path studentPath{studentNumber};
       bfs::path languagePath{studentPath / language};
       std::string se2s03, cases1, cases2;
-      se2s03 = (language == "Haskell") ? "Se2s03" : "se2s03";
-      cases1 = (language == "Haskell") ? "Se2s03.A1.cases" : "cases";
-      cases2 = (language == "Haskell") ? "Se2s03.A2.cases" : "cases";
+      se2s03 = Language::packageName();
+      cases1 = Language::qualifiesMethods() ? se2s03 + ".A1.cases" : "cases";
+      cases2 = Language::qualifiesMethods() ? se2s03 + ".A2.cases" : "cases";
       bfs::path se2s03Path{languagePath / se2s03};
-      std::string extension;
-      if (language == "Java") extension = ".java";
-      else if (language == "JavaScript") extension = ".js";
-      else if (language == "Scheme") extension = ".scm";
-      else if (language == "Haskell") extension = ".hs";
+      const std::string extension{Language::extension()};
 
-      // Print small assert.js program to get asserts in JavaScript
-      if (language == "JavaScript") printAssert_js(languagePath);
-      if (language == "Scheme") printAssert_scm(languagePath);
+      // E.g. a small assert.js program to get asserts in JavaScript
+      Language::printSupport(languagePath);
 
-      // Create if-else tree. First create return blocks:
-      std::vector<std::string> returnValues1, testNames1, testNumbers1;
-
-      Block* myBlock1{new Block};
-      randomizeTree(returnValues1, testNames1, testNumbers1);
-      createIfTreeBlock(returnValues1, testNames1, testNumbers1, myBlock1);
-
-      std::vector<std::string> returnValues2, testNames2, testNumbers2;
-      Block* myBlock2{new Block};
-      randomizeTree(returnValues2, testNames2, testNumbers2);
-      createIfTreeBlock(returnValues2, testNames2, testNumbers2, myBlock2);
-
-      // ...
+      // Create if-else trees
       std::vector<Parameter> casesParams{Parameter{Type::INT, "v"}, 
          Parameter{Type::INT, "u"}, Parameter{Type::INT, "w"}};
-      Boilerplate* myProgram1{createBoilerPlate(se2s03, "A1", myBlock1, 
-            "cases", casesParams, Type::INT)};
-      Boilerplate* myProgram2{createBoilerPlate(se2s03, "A2", myBlock2, 
-            "cases", casesParams, Type::INT)};
+      // Each program is made in an arena of its own, which outlives it
+      NodeArena arena1, arena2;
+      Boilerplate* myProgram1{nullptr};
+      Boilerplate* myProgram2{nullptr};
+      {
+         ArenaScope scope{arena1};
+         myProgram1 = createCasesProgram(se2s03, "A1", casesParams);
+      }
+      {
+         ArenaScope scope{arena2};
+         myProgram2 = createCasesProgram(se2s03, "A2", casesParams);
+      }
 
       writeToFile(se2s03Path, "A1" + extension, myPrinter, myProgram1);
-      printA1A2Tests(myPrinter, myProgram1, "A1", cases1, "A1Test", languagePath);
+      printA1A2Tests(myPrinter, myProgram1, "A1", cases1, "A1Test", languagePath,
+            se2s03, extension);
       writeToFile(se2s03Path, "A2" + extension, myPrinter, myProgram2);
-      printA1A2Tests(myPrinter, myProgram2, "A2", cases2, "A2Test", languagePath);
+      printA1A2Tests(myPrinter, myProgram2, "A2", cases2, "A2Test", languagePath,
+            se2s03, extension);
       if (myProgram1) delete myProgram1;
       if (myProgram2) delete myProgram2;
 }
 
+template void printA1A2<Java>(Printer* myPrinter, const std::string& studentNumber);
+template void printA1A2<JavaScript>(Printer* myPrinter, 
+      const std::string& studentNumber);
+template void printA1A2<Scheme>(Printer* myPrinter, const std::string& studentNumber);
+template void printA1A2<Haskell>(Printer* myPrinter, 
+      const std::string& studentNumber);
+
 //------------------------------------------------------------------------------------
 
 void createInitialization(std::vector<VarDeclFragment*>& a0a1anFragments, 
@@ -519,7 +490,7 @@ void createInitialization(std::vector<VarDeclFragment*>& a0a1anFragments,
 
    // Create recurrence relation.
    std::vector<std::string> variableNames{"a0", "a1", "an", "x", "y"};
-   std::vector<std::string> variableValues(variableNames.size()); // {"","","","",""}
+   std::vector<int> variableValues(variableNames.size());
    
    // Not-so-random fixing of values to avoid repeating series
    int a0, x, value{rnd()};
@@ -527,18 +498,18 @@ void createInitialization(std::vector<VarDeclFragment*>& a0a1anFragments,
    a0 = value;
    while (value == 0 || std::abs(value) == std::abs(a0)) value = rnd();
    x = signum(a0) * std::abs(value);
-   variableValues.at(0) = std::to_string(a0);
-   variableValues.at(1) = std::to_string(-x);
-   variableValues.at(2) = std::to_string(-x);
-   variableValues.at(3) = std::to_string(x);
-   variableValues.at(4) = std::to_string(-a0);
+   variableValues.at(0) = a0;
+   variableValues.at(1) = -x;
+   variableValues.at(2) = -x;
+   variableValues.at(3) = x;
+   variableValues.at(4) = -a0;
 
    // int x = 1, y = -3;
    std::vector<Name*> varNamePtrs;
    std::vector<NumberLiteral*> varValPtrs;
    for (unsigned i=0; i<variableNames.size(); ++i) {
-      varNamePtrs.push_back(new Name{variableNames.at(i)});
-      varValPtrs.push_back(new NumberLiteral{variableValues.at(i)});
+      varNamePtrs.push_back(NodeFactory::global().name(variableNames.at(i)));
+      varValPtrs.push_back(NodeFactory::global().number(variableValues.at(i)));
    }
 
    // a0, a1 and an declarations go on one line; x and y declarations go on the next.
@@ -556,15 +527,15 @@ void createInitialization(std::vector<VarDeclFragment*>& a0a1anFragments,
 void createForBlock(Block* forBlock)
 {
    // { an = x*a0 + y*a1; a0 = a1; a1 = an; }
-   InfixExpression* xTimesa0{new InfixExpression{new Name{"x"}, InfixOperator::TIMES,
-      new Name{"a0"}}};
-   InfixExpression* yTimesa1{new InfixExpression{new Name{"y"}, InfixOperator::TIMES,
-      new Name{"a1"}}};
-   InfixExpression* xa0Plusya1{new InfixExpression{xTimesa0, 
-      InfixOperator::PLUS, yTimesa1}};
-   forBlock->addStatement(new AssignmentStatement{new Name{"an"}, xa0Plusya1});
-   forBlock->addStatement(new AssignmentStatement{new Name{"a0"}, new Name{"a1"}});
-   forBlock->addStatement(new AssignmentStatement{new Name{"a1"}, new Name{"an"}});
+   NodeFactory& nodes = NodeFactory::global();
+   InfixExpression* xTimesa0{nodes.infix(nodes.name("x"), InfixOperator::TIMES,
+      nodes.name("a0"))};
+   InfixExpression* yTimesa1{nodes.infix(nodes.name("y"), InfixOperator::TIMES,
+      nodes.name("a1"))};
+   InfixExpression* xa0Plusya1{nodes.infix(xTimesa0, InfixOperator::PLUS, yTimesa1)};
+   forBlock->addStatement(new AssignmentStatement{nodes.name("an"), xa0Plusya1});
+   forBlock->addStatement(new AssignmentStatement{nodes.name("a0"), nodes.name("a1")});
+   forBlock->addStatement(new AssignmentStatement{nodes.name("a1"), nodes.name("an")});
 }
 
 //------------------------------------------------------------------------------------
@@ -578,101 +549,152 @@ void createRecurrenceBlock(Block* myBlock)
    myBlock->addStatement(new VarDeclStatement{xyFragments, Type::INT});
 
    // if (n==0) return a0;
-   InfixExpression* nEqualsZeroInfix{new InfixExpression{new Name{"n"}, 
-      InfixOperator::EQUALS, new NumberLiteral{"0"}}};
-   ReturnStatement* nEqualsZeroReturn{new ReturnStatement{new Name{"a0"}}};
+   NodeFactory& nodes = NodeFactory::global();
+   InfixExpression* nEqualsZeroInfix{nodes.infix(nodes.name("n"), 
+      InfixOperator::EQUALS, nodes.number(0))};
+   ReturnStatement* nEqualsZeroReturn{new ReturnStatement{nodes.name("a0")}};
    myBlock->addStatement(new IfStatement{nEqualsZeroInfix, nEqualsZeroReturn});
    // if (n==1) return a1;
-   InfixExpression* nEqualsOneInfix{new InfixExpression{new Name{"n"}, 
-      InfixOperator::EQUALS, new NumberLiteral{"1"}}};
-   ReturnStatement* nEqualsOneReturn{new ReturnStatement{new Name{"a1"}}};
+   InfixExpression* nEqualsOneInfix{nodes.infix(nodes.name("n"), 
+      InfixOperator::EQUALS, nodes.number(1))};
+   ReturnStatement* nEqualsOneReturn{new ReturnStatement{nodes.name("a1")}};
    myBlock->addStatement(new IfStatement{nEqualsOneInfix, nEqualsOneReturn});
 
    // for (int i=2; i<=n; i++) { an = x*a0 + y*a1; a0 = a1; a1 = an; }
-   std::vector<VarDeclFragment*> forInit{new VarDeclFragment{new Name{"i"}, 
-      new NumberLiteral{"2"}, Type::INT}};
-   std::vector<Expression*> forUpdaters{new PostfixExpression{new Name{"i"}, 
-      PostfixOperator::INCREMENT}};
+   std::vector<VarDeclFragment*> forInit{new VarDeclFragment{nodes.name("i"), 
+      nodes.number(2), Type::INT}};
+   std::vector<Expression*> forUpdaters{nodes.postfix(nodes.name("i"), 
+      PostfixOperator::INCREMENT)};
    Block* forBlock{new Block};
    createForBlock(forBlock);
-   myBlock->addStatement(new ForStatement{forInit, new InfixExpression{new Name{"i"},
-         InfixOperator::LESS_EQUALS, new Name{"n"}}, forUpdaters, forBlock});
+   myBlock->addStatement(new ForStatement{forInit, nodes.infix(nodes.name("i"),
+         InfixOperator::LESS_EQUALS, nodes.name("n")), forUpdaters, forBlock});
    // return an;
-   myBlock->addStatement(new ReturnStatement{new Name{"an"}});
+   myBlock->addStatement(new ReturnStatement{nodes.name("an")});
 }
 
 //------------------------------------------------------------------------------------
 
-void printA3(Printer* myPrinter, const std::string& studentNumber,
-      const std::string& language)
+template <typename Language> 
+void printA3(Printer* myPrinter, const std::string& studentNumber)
 {
    namespace bfs = boost::filesystem;
    bfs::path studentPath{studentNumber};
-   bfs::path languagePath{studentPath / language};
-   std::string se2s03{(language == "Haskell") ? "Se2s03" : "se2s03"};
-   std::string Rec{(language == "Haskell") ? "rec" : "Rec"};
+   bfs::path languagePath{studentPath / Language::name()};
+   std::string se2s03{Language::packageName()};
+   std::string Rec{Language::recurrenceName()};
    bfs::path se2s03Path{languagePath / se2s03};
-   std::string extension;
-   if (language == "Java") extension = ".java";
-   else if (language == "JavaScript") extension = ".js";
-   else if (language == "Scheme") extension = ".scm";
-   else if (language == "Haskell") extension = ".hs";
-
-   Block* myBlock{new Block};
-   createRecurrenceBlock(myBlock);
-
-   std::vector<Parameter> recParams{Parameter{Type::INT, "n"}};
-   Boilerplate* myProgram{createBoilerPlate(se2s03, "A3", myBlock,
-         Rec, recParams, Type::INT)};
+   const std::string extension{Language::extension()};
+
+   NodeArena arena;
+   Boilerplate* myProgram{nullptr};
+   {
+      ArenaScope scope{arena};
+      Block* myBlock{new Block};
+      createRecurrenceBlock(myBlock);
+
+      std::vector<Parameter> recParams{Parameter{Type::INT, "n"}};
+      myProgram = createBoilerPlate(se2s03, "A3", myBlock, Rec, recParams,
+            Type::INT);
+   }
    writeToFile(se2s03Path, "A3" + extension, myPrinter, myProgram);
-   printA3Tests(myPrinter, myProgram, "A3", Rec, "A3Test", languagePath);
+   printA3Tests(myPrinter, myProgram, "A3", Rec, "A3Test", languagePath, se2s03,
+         extension);
    if (myProgram) delete myProgram;
 }
 
+template void printA3<Java>(Printer* myPrinter, const std::string& studentNumber);
+template void printA3<JavaScript>(Printer* myPrinter, 
+      const std::string& studentNumber);
+template void printA3<Scheme>(Printer* myPrinter, const std::string& studentNumber);
+template void printA3<Haskell>(Printer* myPrinter, const std::string& studentNumber);
+
+//------------------------------------------------------------------------------------
+
+Boilerplate* createCasesProgram(const std::string& packageName, 
+      const std::string& className, const std::vector<Parameter>& params)
+{
+   // Almost every tree drawn is kept, so running out of draws means something
+   // is wrong with the tree generator rather than bad luck
+   const unsigned MAX_DRAWS{100};
+   for (unsigned draw=0; draw<MAX_DRAWS; ++draw) {
+      std::vector<std::string> returnValues, testNames, testNumbers;
+      Block* myBlock{new Block};
+      randomizeTree(returnValues, testNames, testNumbers);
+      createIfTreeBlock(returnValues, testNames, testNumbers, myBlock);
+      Boilerplate* myProgram{createBoilerPlate(packageName, className, myBlock, 
+            "cases", params, Type::INT)};
+      if (sweepInputDomain(myProgram, TEST_RANGE).allReturnsReached()) 
+         return myProgram;
+      delete myProgram;
+   }
+   throw BadSize{};
+}
+
 //------------------------------------------------------------------------------------
 
 void printA1A2Tests(Printer* myPrinter, Boilerplate* myProgram, 
       const std::string& className, const std::string& methodName, 
-      const std::string& name, boost::filesystem::path studentPath)
+      const std::string& name, boost::filesystem::path studentPath,
+      const std::string& packageName, const std::string& extension)
 {
    const unsigned NUMBER_TESTS{205};
-   const int TEST_RANGE{100};
    Rand_int rnd{-TEST_RANGE, TEST_RANGE}; // test values in [-100, 100]
    std::vector<std::string> params{"v", "u", "w"};
-   std::string languageName;
-   std::string tempPathName{studentPath.c_str()};
-   for (unsigned i=8; i<tempPathName.size(); ++i) 
-      languageName.push_back(tempPathName.at(i));
-
-   std::string se2s03;
-   se2s03 = (languageName == "Haskell") ? "Se2s03" : "se2s03";
-   TesterBoilerplate* tester{new TesterBoilerplate{se2s03, className, methodName,
-      name}};
-
-   std::string extension;
-   if (languageName == "Java") extension = ".java";
-   else if (languageName == "JavaScript") extension = ".js";
-   else if (languageName == "Scheme") extension = ".scm";
-   else if (languageName == "Haskell") extension = ".hs";
+   TesterBoilerplate* tester{new TesterBoilerplate{packageName, className, 
+      methodName, name, static_cast<unsigned>(params.size())}};
 
    std::string csvFileName{className + ".csv"};
    boost::filesystem::path csvPath{studentPath / csvFileName};
    std::ofstream outFileStream{csvPath.c_str()};
+   OutputSink csv{outFileStream};
+
+   // Draw every test first, one array per parameter, so that the tests can be
+   // evaluated BATCH_LANES at a time.
+   std::vector<std::vector<int>> testArgs(params.size(), 
+         std::vector<int>(NUMBER_TESTS));
+   for (unsigned i=0; i<NUMBER_TESTS; ++i)
+      for (unsigned j=0; j<params.size(); ++j)
+         testArgs.at(j).at(i) = rnd();
+   // Every return statement gets a test: the first input that reaches it is
+   // added for those that none of the random tests reach.
+   SweepReport covered{sweepInputs(myProgram, testArgs, NUMBER_TESTS)};
+   if (!covered.allReturnsReached()) {
+      SweepReport domain{sweepInputDomain(myProgram, TEST_RANGE)};
+      for (unsigned r=0; r<covered.returns.size(); ++r) {
+         if (covered.returnHits.at(r) > 0) continue;
+         for (unsigned j=0; j<params.size(); ++j)
+            testArgs.at(j).push_back(domain.firstInputs.at(r).at(j));
+      }
+   }
+   const unsigned numberTests{static_cast<unsigned>(testArgs.front().size())};
+
+   std::vector<int> results;
+   std::vector<int> args(params.size());
+   DecisionTable table;
+   if (table.build(myProgram)) {
+      results.resize(numberTests);
+      for (unsigned i=0; i<numberTests; ++i) {
+         for (unsigned j=0; j<params.size(); ++j) args.at(j) = testArgs.at(j).at(i);
+         results.at(i) = table.lookup(args);
+      }
+   }
+   else evaluateBatches(myProgram, testArgs, numberTests, results);
 
-   for (unsigned i=0; i<NUMBER_TESTS; ++i) {
-      std::vector<int> randomArgs;
+   AssertBlock& asserts = tester->getAsserts();
+   asserts.reserve(numberTests);
+   for (unsigned i=0; i<numberTests; ++i) {
       for (unsigned j=0; j<params.size(); ++j) {
-         randomArgs.push_back(rnd());
-         outFileStream << randomArgs.back() << ", ";
+         args.at(j) = testArgs.at(j).at(i);
+         csv << args.at(j) << ", ";
       }
-      ResultFinder myFinder{randomArgs, params};
-      myProgram->accept(&myFinder);
-      tester->addAssert(new AssertStatement{methodName, randomArgs, 
-            std::stoi(myFinder.getResult())});
-      outFileStream << myFinder.getResult() << std::endl;
+      asserts.add(args.data(), results.at(i));
+      csv << results.at(i) << '\n';
    }
    std::string fileName = name + extension;
    writeToFile(studentPath, fileName, myPrinter, tester);
+   // The program and its tests, for reprinting or evaluating them later
+   keepProgramFile(studentPath, className, myProgram, tester);
    if (tester) delete tester;
 }
 
@@ -680,41 +702,52 @@ void printA1A2Tests(Printer* myPrinter, Boilerplate* myProgram,
 
 void printA3Tests(Printer* myPrinter, Boilerplate* myProgram,
       const std::string& className, const std::string& methodName,
-      const std::string& name, boost::filesystem::path studentPath)
+      const std::string& name, boost::filesystem::path studentPath,
+      const std::string& packageName, const std::string& extension)
 {
    const unsigned NUMBER_TESTS{18};
-   std::vector<std::string> params{"n"};
-
-   std::string languageName;
-   std::string tempPathName{studentPath.c_str()};
-   for (unsigned i=8; i<tempPathName.size(); ++i) 
-      languageName.push_back(tempPathName.at(i));
-
-   std::string se2s03;
-   se2s03 = (languageName == "Haskell") ? "Se2s03" : "se2s03";
-   TesterBoilerplate* tester{new TesterBoilerplate{se2s03, className, methodName,
-      name}};
+   // Tests for these larger n are added for as long as the results still fit
+   // in the int returned by the generated methods.
+   const std::vector<int> LARGE_N{25, 50, 100, 1000, 10000, 100000};
 
-   std::string extension;
-   if (languageName == "Java") extension = ".java";
-   else if (languageName == "JavaScript") extension = ".js";
-   else if (languageName == "Scheme") extension = ".scm";
-   else if (languageName == "Haskell") extension = ".hs";
+   TesterBoilerplate* tester{new TesterBoilerplate{packageName, className, 
+      methodName, name, 1}};
 
    std::string csvFileName{className + ".csv"};
    boost::filesystem::path csvPath{studentPath / csvFileName};
    std::ofstream outFileStream{csvPath.c_str()};
-   std::vector<int> randomArgs{0}; // "random"
+   OutputSink csv{outFileStream};
+   std::vector<int> testN;
+   std::vector<int> results;
+   // The recurrence is evaluated in O(log n)
+   RecurrenceEvaluator evaluator;
    for (unsigned i=1; i <= NUMBER_TESTS; ++i) {
-      outFileStream << i << ", ";
-      randomArgs.front() = i; 
-      ResultFinder myFinder{randomArgs, params};
-      myProgram->accept(&myFinder);
-      tester->addAssert(new AssertStatement{methodName, randomArgs, 
-            std::stoi(myFinder.getResult())});
-      outFileStream << myFinder.getResult() << std::endl;
+      testN.push_back(i);
+      // Wraps around like the int arithmetic in the generated Java
+      results.push_back(static_cast<int>(evaluator.evaluate(myProgram, 
+                  std::vector<long long>{i})));
+   }
+   try {
+      for (int n : LARGE_N) {
+         long long result{evaluator.evaluate(myProgram, std::vector<long long>{n})};
+         if (result < std::numeric_limits<int>::min() || 
+               result > std::numeric_limits<int>::max())
+            break;
+         testN.push_back(n);
+         results.push_back(result);
+      }
+   }
+   catch (BadSize) {} // overflowed 64 bits, so larger n would too
+
+   tester->getAsserts().reserve(testN.size());
+   for (unsigned i=0; i<testN.size(); ++i) {
+      csv << testN.at(i) << ", ";
+      tester->getAsserts().add(&testN.at(i), results.at(i));
+      csv << results.at(i) << '\n';
    }
    std::string fileName = name + extension;
    writeToFile(studentPath, fileName, myPrinter, tester);
+   // The program and its tests, for reprinting or evaluating them later
+   keepProgramFile(studentPath, className, myProgram, tester);
    if (tester) delete tester;
 }
@@ -7,6 +7,12 @@
 #include <exception>
 #include <algorithm>
 #include <random>
+#include <unordered_map>
+#include <map>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
 
 class BadPath{}; // For throwing file-existence errors
 class BadSize{}; // For throwing range errors
@@ -54,28 +60,123 @@ enum class PostfixOperator {
 
 //------------------------------------------------------------------------------------
 
-// E.g. returns "void" for Type::VOID
-std::string typeToString(const Type t);
+// One for each concrete subclass of ASTNode
+enum class NodeKind : unsigned char {
+   TESTER_BOILERPLATE, BOILERPLATE, METHOD_DECLARATION, VAR_DECL_STATEMENT,
+   ASSERT_STATEMENT, BLOCK, RETURN_STATEMENT, ASSIGNMENT_STATEMENT, IF_STATEMENT,
+   FOR_STATEMENT, NAME, BOOLEAN_LITERAL, NUMBER_LITERAL, INFIX_EXPRESSION,
+   POSTFIX_EXPRESSION, VAR_DECL_FRAGMENT
+};
 
 //------------------------------------------------------------------------------------
 
-std::string infixOpToString(const InfixOperator infixOperator);
+// Language policies: what is written differently in each target language, all
+// of it known at compile time. LanguagePrinter and the test drivers printA1A2()
+// and printA3() are templates on them, so adding a language means adding a
+// policy (and specialising the visits the language prints its own way), not
+// another class. LanguageDefaults has what most of the languages share.
+struct LanguageDefaults {
+   static constexpr const char* packageName() { return "se2s03"; }
+   // Whether tests call a method by its qualified name, e.g. Se2s03.A1.cases
+   static constexpr bool qualifiesMethods() { return false; }
+   static constexpr const char* recurrenceName() { return "Rec"; }
+   static constexpr const char* infixOp(InfixOperator op)
+   {
+      return op == InfixOperator::LESS_EQUALS ? "<=" :
+         op == InfixOperator::EQUALS ? "==" :
+         op == InfixOperator::PLUS ? "+" :
+         op == InfixOperator::TIMES ? "*" :
+         op == InfixOperator::ASSIGNMENT ? "=" : "_ERROR_";
+   }
+   static constexpr const char* postfixOp(PostfixOperator op)
+   {
+      return op == PostfixOperator::INCREMENT ? "++" :
+         op == PostfixOperator::DECREMENT ? "--" : "_ERROR_";
+   }
+   // Writes any files the tests need besides the programs and testers
+   static void printSupport(const boost::filesystem::path& languagePath) {}
+};
 
 //------------------------------------------------------------------------------------
 
-std::string postfixOpToString(const PostfixOperator postfixOperator);
+struct Java : LanguageDefaults {
+   // Also the name of the language's directory
+   static constexpr const char* name() { return "Java"; }
+   static constexpr const char* extension() { return ".java"; }
+   // How a declaration of type t is written, e.g. "void" for Type::VOID
+   static constexpr const char* typeName(Type t)
+   {
+      return t == Type::VOID ? "void" : t == Type::BOOL ? "boolean" :
+         t == Type::INT ? "int" : "_ERROR_";
+   }
+   static constexpr const char* forKeyword() { return "for ("; }
+};
 
 //------------------------------------------------------------------------------------
 
-std::string infixOpToStringJs(const InfixOperator infixOperator);
+struct JavaScript : LanguageDefaults {
+   static constexpr const char* name() { return "JavaScript"; }
+   static constexpr const char* extension() { return ".js"; }
+   static constexpr const char* typeName(Type t) { return "var"; }
+   static constexpr const char* forKeyword() { return " for ("; }
+   static constexpr const char* infixOp(InfixOperator op)
+   {
+      return op == InfixOperator::EQUALS ? "===" : LanguageDefaults::infixOp(op);
+   }
+   // assert.js
+   static void printSupport(const boost::filesystem::path& languagePath);
+};
 
 //------------------------------------------------------------------------------------
 
-std::string infixOpToStringScm(const InfixOperator infixOperator);
+// 3 languages, 3 ways to write equality
+struct Scheme : LanguageDefaults {
+   static constexpr const char* name() { return "Scheme"; }
+   static constexpr const char* extension() { return ".scm"; }
+   static constexpr const char* infixOp(InfixOperator op)
+   {
+      return op == InfixOperator::EQUALS ? "=" : LanguageDefaults::infixOp(op);
+   }
+   static constexpr const char* postfixOp(PostfixOperator op)
+   {
+      return op == PostfixOperator::INCREMENT ? "+" :
+         op == PostfixOperator::DECREMENT ? "-" : "_ERROR_";
+   }
+   // assert.scm
+   static void printSupport(const boost::filesystem::path& languagePath);
+};
 
 //------------------------------------------------------------------------------------
 
-std::string postfixOpToStringScm(const PostfixOperator postfixOperator);
+struct Haskell : LanguageDefaults {
+   static constexpr const char* name() { return "Haskell"; }
+   static constexpr const char* extension() { return ".hs"; }
+   // Module names are capitalised, and function names aren't
+   static constexpr const char* packageName() { return "Se2s03"; }
+   static constexpr bool qualifiesMethods() { return true; }
+   static constexpr const char* recurrenceName() { return "rec"; }
+};
+
+//------------------------------------------------------------------------------------
+
+// Interns identifiers, giving each distinct one a small fixed integer. Evaluators
+// use these integers as slots, so a variable access is a single array index
+// rather than a search through the names in scope. Slots are shared by every
+// program in a run; a program only uses the few slots of its own identifiers.
+class SymbolTable {
+public:
+   static SymbolTable& global();
+
+   int intern(const std::string& identifier);
+   // Returns -1 if identifier hasn't been interned. Unlike intern() it doesn't
+   // change the table, so threads evaluating programs can call it.
+   int find(const std::string& identifier) const;
+   const std::string& getIdentifier(int slot) const { return m_identifiers.at(slot); }
+   int size() const { return m_identifiers.size(); }
+private:
+   std::unordered_map<std::string, int> m_slots;
+   std::vector<std::string> m_identifiers;
+};
 
 //------------------------------------------------------------------------------------
 
@@ -107,6 +208,8 @@ struct InfixExpression;
 struct PostfixExpression;
 struct VarDeclFragment;
 
+class ExpressionDag;
+
 //------------------------------------------------------------------------------------
 
 class ASTVisitor {
@@ -131,6 +234,102 @@ public:
 
 //------------------------------------------------------------------------------------
 
+// An append-only buffer that printers write to. Nothing reaches the stream it
+// is bound to until flush(), which writes all of the buffer at once, so a file
+// is written in one go instead of being flushed at the end of every line.
+class OutputSink {
+public:
+   OutputSink() {}
+   explicit OutputSink(std::ostream& os) :m_os{&os} {}
+   ~OutputSink() { flush(); }
+   OutputSink(const OutputSink&) = delete;
+   OutputSink& operator=(const OutputSink&) = delete;
+
+   // Writes the buffer to the stream and empties it. A sink bound to no stream
+   // keeps its buffer.
+   void flush();
+   // Flushes, then writes to os from now on
+   void setStream(std::ostream& os);
+   const std::string& getBuffer() const { return m_buffer; }
+
+   OutputSink& operator<<(char c) 
+   { 
+      m_buffer.push_back(c); 
+      return *this;
+   }
+   OutputSink& operator<<(const char* s) 
+   { 
+      m_buffer.append(s); 
+      return *this;
+   }
+   OutputSink& operator<<(const std::string& s) 
+   { 
+      m_buffer.append(s); 
+      return *this;
+   }
+   OutputSink& operator<<(int i);
+   OutputSink& operator<<(unsigned i);
+   OutputSink& append(const char* s, std::size_t n)
+   {
+      m_buffer.append(s, n);
+      return *this;
+   }
+
+   // Writes made by flush(), and the bytes in them, by this sink and by all
+   // sinks so far
+   unsigned long long numberFlushes() const { return m_flushes; }
+   unsigned long long numberBytes() const { return m_bytes; }
+   static unsigned long long totalFlushes() { return m_totalFlushes; }
+   static unsigned long long totalBytes() { return m_totalBytes; }
+private:
+   std::ostream* m_os{nullptr};
+   std::string m_buffer;
+   unsigned long long m_flushes{0};
+   unsigned long long m_bytes{0};
+   static unsigned long long m_totalFlushes;
+   static unsigned long long m_totalBytes;
+};
+
+//------------------------------------------------------------------------------------
+
+struct Printer;
+
+// What a printer prints for a program, with a numbered hole for each of its
+// number literals, numbered in the order ProgramShape has them. Filling the
+// holes with the numbers of another program of the same shape gives what the
+// printer prints for that program, without walking it. That holds only if the
+// printer printed every literal once, as itself; where it didn't (Haskell's
+// loops are printed from an ExpressionDag, which merges equal constants), the
+// template can't be filled, and programs of its shape are printed by accept().
+class OutputTemplate {
+public:
+   OutputTemplate(Printer& printer, Boilerplate* program);
+
+   // Whether the template is of the shape described, and can be filled
+   bool fits(const std::string& shape) const 
+   { 
+      return m_fillable && shape == m_shape; 
+   }
+   void fill(const std::vector<int>& numbers, OutputSink& sink) const;
+   unsigned numberHoles() const { return m_holes.size(); }
+private:
+   friend struct Printer;
+
+   struct Hole {
+      std::size_t at; // in m_text
+      unsigned number;
+   };
+
+   void addHole(const OutputSink& sink, int number);
+
+   std::string m_shape;
+   bool m_fillable{false};
+   std::string m_text;
+   std::vector<Hole> m_holes;
+};
+
+//------------------------------------------------------------------------------------
+
 struct Printer : ASTVisitor {
    Printer(const std::string& indentType) :m_indentType{indentType} {}
 
@@ -151,14 +350,38 @@ struct Printer : ASTVisitor {
    virtual void visit(PostfixExpression* postfixExpression) = 0;
    virtual void visit(VarDeclFragment* varDeclFragment) = 0;
 
-   void setOutStream(std::ostream& os) { m_os = &os; }
+   // Prints to sink, which the caller flushes
+   void setOutStream(OutputSink& sink) { m_out = &sink; }
+   // Prints to os through the printer's own sink, which is flushed by flush(),
+   // when the printer is given another stream and when it's destroyed
+   void setOutStream(std::ostream& os) 
+   { 
+      m_sink.setStream(os); 
+      m_out = &m_sink;
+   }
+   void flush() { m_out->flush(); }
+   // Prints program as accept() would, from the template made the first time a
+   // program of its shape was printed
+   void printByTemplate(Boilerplate* program);
    void printIndents() const;
    void printIntVector(const std::vector<int>& v) const;
+   void printIntVector(const int* v, unsigned size) const;
    void incrementIndents() { ++m_indents; }
    void decrementIndents() { --m_indents; }
    void setIndents(int i) { m_indents = i; }
+private:
+   friend class OutputTemplate;
+
+   OutputSink m_sink{std::cout};
+   // The template being made, if any, and those made so far by shape hash. A
+   // template found by hash is used only if it fits the whole shape.
+   OutputTemplate* m_template{nullptr};
+   std::unordered_map<std::uint64_t, OutputTemplate> m_templates;
 protected:
-   std::ostream* m_os = &std::cout;
+   // Prints a number literal, or a hole for it while a template is being made
+   void printNumber(const NumberLiteral* numberLiteral);
+
+   OutputSink* m_out = &m_sink;
    std::string m_indentType;
 private:
    int m_indents{0};
@@ -166,20 +389,129 @@ private:
 
 //------------------------------------------------------------------------------------
 
+// Memory for ASTNodes, handed out from large chunks by bumping a pointer and
+// given back all at once. While an ArenaScope for an arena exists, every ASTNode
+// made on that thread is placed in it; other nodes are on the heap as before.
+// Deleting an arena's node runs its destructor but leaves its memory to the
+// arena, so a program's nodes must be deleted before its arena is reset or
+// destroyed. The nodes of a shared arena belong to whoever made them, and
+// ASTNode::release() leaves them alone (see NodeFactory).
+class NodeArena {
+public:
+   explicit NodeArena(std::size_t chunkSize = 64 * 1024, bool shared = false)
+      :m_chunkSize{chunkSize}, m_shared{shared} {}
+   NodeArena(const NodeArena&) = delete;
+   NodeArena& operator=(const NodeArena&) = delete;
+   ~NodeArena();
+
+   void* allocate(std::size_t size);
+   // Gives back the memory of every node, keeping the first chunk for reuse
+   void reset();
+
+   // The arena of the calling thread's innermost ArenaScope, if any
+   static NodeArena* current();
+
+   bool isShared() const { return m_shared; }
+   std::size_t numberBytes() const { return m_bytes; }
+   unsigned numberNodes() const { return m_nodes; }
+
+   // Totals over the programs held by unshared arenas so far, each counted when
+   // its arena is reset or destroyed: the number of programs, their nodes and
+   // bytes, and the most bytes any one of them took
+   static unsigned long long totalPrograms() { return m_totalPrograms; }
+   static unsigned long long totalNodes() { return m_totalNodes; }
+   static unsigned long long totalBytes() { return m_totalBytes; }
+   static std::size_t largestProgram() { return m_largestProgram; }
+private:
+   friend class ArenaScope;
+
+   void addToTotals();
+
+   static unsigned long long m_totalPrograms;
+   static unsigned long long m_totalNodes;
+   static unsigned long long m_totalBytes;
+   static std::size_t m_largestProgram;
+
+   std::size_t m_chunkSize;
+   bool m_shared;
+   std::vector<char*> m_chunks;
+   char* m_next{nullptr};
+   char* m_end{nullptr};
+   std::size_t m_bytes{0};
+   unsigned m_nodes{0};
+};
+
+//------------------------------------------------------------------------------------
+
+class ArenaScope {
+public:
+   explicit ArenaScope(NodeArena& arena);
+   ArenaScope(const ArenaScope&) = delete;
+   ArenaScope& operator=(const ArenaScope&) = delete;
+   ~ArenaScope();
+private:
+   NodeArena* m_previous;
+};
+
+//------------------------------------------------------------------------------------
+
 class ASTNode {
 public:
+   // Nodes are placed in the current NodeArena, if there is one
+   static void* operator new(std::size_t size);
+   static void operator delete(void* node);
+
+   // Whether node is in a shared arena, and so may have several parents
+   static bool isShared(const ASTNode* node);
+   // Deletes node, unless it is null or shared. Parents free their children
+   // with this rather than delete.
+   static void release(ASTNode* node);
+
    virtual void accept(ASTVisitor* visitor) = 0;
-   // add delete() function? ASTNode* m_parent and ASTNode* m_child members?
    // Virtual destructor so that proper subclass destructor is called if that
    // subclass is deleted through a pointer to its base class.
    virtual ~ASTNode() {}
+
+   // Hash of the subtree at this node, equal for structurally equal subtrees
+   // in any program of any run (see StructuralHasher). It is worked out afresh,
+   // walking the whole subtree, on every call: nodes don't know their parents,
+   // and shared ones have many, so a hash kept in a node couldn't be told
+   // that a descendant changed.
+   std::uint64_t hash();
+
+   // Which subclass this is, for dispatch()
+   NodeKind getKind() const { return m_kind; }
 protected:
-   ASTNode(ASTNode* parent)
-      :m_parent{parent} {}
+   explicit ASTNode(NodeKind kind) :m_kind{kind} {}
+private:
+   NodeKind m_kind;
+};
+
+//------------------------------------------------------------------------------------
+
+// The asserts of a tester, which are all of one method: row i says that given
+// the getArity() arguments at getArgs(i), it returns getResult(i). The rows are
+// kept in flat arrays rather than a node each; printers go through them with
+// an AssertStatement.
+class AssertBlock {
+public:
+   AssertBlock(const std::string& methodName, unsigned arity)
+      :m_methodName{methodName}, m_arity{arity} {}
+
+   void reserve(unsigned numberRows);
+   // args holds getArity() ints
+   void add(const int* args, int result);
+
+   const std::string& getMethodName() const { return m_methodName; }
+   unsigned getArity() const { return m_arity; }
+   unsigned size() const { return m_results.size(); }
+   const int* getArgs(unsigned row) const { return m_args.data() + row * m_arity; }
+   int getResult(unsigned row) const { return m_results.at(row); }
 private:
-   // m_parent currently unused. Consider removing, or implementing features that
-   // use traversing up a tree, if needed?
-   ASTNode* m_parent;
+   std::string m_methodName;
+   unsigned m_arity;
+   std::vector<int> m_args; // row after row
+   std::vector<int> m_results;
 };
 
 //------------------------------------------------------------------------------------
@@ -187,12 +519,10 @@ private:
 // For now just a quick-fix to get the boilerplate for A1Test.java etc. up.
 struct TesterBoilerplate : ASTNode {
    TesterBoilerplate(const std::string& packageName, const std::string& className,
-         const std::string& methodName, const std::string& name, 
-         ASTNode* parent = nullptr)
-      :ASTNode{parent}, m_packageName{packageName}, m_className{className}, 
-      m_methodName{methodName}, m_name{name} {}
-
-   ~TesterBoilerplate(); 
+         const std::string& methodName, const std::string& name, unsigned arity)
+      :ASTNode{NodeKind::TESTER_BOILERPLATE},
+      m_packageName{packageName}, m_className{className}, 
+      m_methodName{methodName}, m_name{name}, m_asserts{methodName, arity} {}
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
@@ -200,12 +530,12 @@ struct TesterBoilerplate : ASTNode {
    const std::string& getPackageName() const { return m_packageName; }
    const std::string& getClassName() const { return m_className; }
    const std::string& getMethodName() const { return m_methodName; }
-   const std::vector<AssertStatement*>& getAsserts() const { return m_asserts; }
-   void addAssert(AssertStatement* assert) { m_asserts.push_back(assert); }
+   const AssertBlock& getAsserts() const { return m_asserts; }
+   AssertBlock& getAsserts() { return m_asserts; }
 private:
    std::string m_packageName, m_className, m_methodName;
    std::string m_name;
-   std::vector<AssertStatement*> m_asserts;
+   AssertBlock m_asserts;
 };
 
 //------------------------------------------------------------------------------------
@@ -213,8 +543,7 @@ private:
 struct Declaration : ASTNode {
    virtual ~Declaration() {}
 protected:
-   Declaration(ASTNode* parent)
-      :ASTNode{parent} {}
+   Declaration(NodeKind kind) :ASTNode{kind} {}
 }; // Base class for all declarations (also virtual)
 
 //------------------------------------------------------------------------------------
@@ -222,8 +551,7 @@ protected:
 struct Statement : ASTNode {
    virtual ~Statement() {}
 protected:
-   Statement(ASTNode* parent)
-      :ASTNode{parent} {}
+   Statement(NodeKind kind) :ASTNode{kind} {}
 }; // Base class for all statements (also virtual)
 
 //------------------------------------------------------------------------------------
@@ -231,25 +559,25 @@ protected:
 struct Expression : ASTNode {
    virtual ~Expression() {}
 protected:
-   Expression(ASTNode* parent)
-      :ASTNode{parent} {}
+   Expression(NodeKind kind) :ASTNode{kind} {}
 };
  // Base class for all expressions (also virtual)
 
 //------------------------------------------------------------------------------------
 
 struct Boilerplate : Declaration {
-   Boilerplate(const std::vector<std::string>& names, ASTNode* parent = nullptr)
-      :Declaration{parent}, m_names{names} {}
+   Boilerplate(const std::vector<std::string>& names)
+      :Declaration{NodeKind::BOILERPLATE}, m_names{names} {}
    Boilerplate(const std::vector<std::string>& names, 
-         const std::vector<Declaration*>& declarations, ASTNode* parent = nullptr)
-      :Declaration{parent}, m_names{names}, m_decls{declarations} {}
+         const std::vector<Declaration*>& declarations)
+      :Declaration{NodeKind::BOILERPLATE}, m_names{names}, m_decls{declarations} {}
 
-   ~Boilerplate() { for (Declaration* d : m_decls) if (d) delete d; }
+   ~Boilerplate() { for (Declaration* d : m_decls) release(d); }
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
    const std::string& getName(unsigned i) const { return m_names.at(i); }
+   const std::vector<std::string>& getNames() const { return m_names; }
    std::vector<Declaration*>& getBodyDeclarations() { return m_decls; }
 
    void setName(unsigned i, const std::string& name) { m_names.at(i) = name; }
@@ -266,13 +594,14 @@ private:
 // MethodDeclaration (and ClassDeclaration) would need a modifier member type.
 struct MethodDeclaration : Declaration {
    MethodDeclaration(Block* block, const std::string& name, 
-         const std::vector<Parameter>& parameters, Type returnType = Type::VOID, 
-         ASTNode* parent = nullptr)
-      :Declaration{parent}, m_body{block}, m_name{name}, m_params{parameters}, 
+         const std::vector<Parameter>& parameters, Type returnType = Type::VOID)
+      :Declaration{NodeKind::METHOD_DECLARATION},
+      m_body{block}, m_name{name}, m_params{parameters}, 
       m_returnType{returnType} {}
    MethodDeclaration(Block* block, const std::string& name, 
-         Type returnType = Type::VOID, ASTNode* parent = 0)
-      :Declaration{parent}, m_body{block}, m_name{name}, m_returnType{returnType} {}
+         Type returnType = Type::VOID)
+      :Declaration{NodeKind::METHOD_DECLARATION},
+      m_body{block}, m_name{name}, m_returnType{returnType} {}
 
    ~MethodDeclaration();
 
@@ -295,9 +624,8 @@ private:
 //------------------------------------------------------------------------------------
 
 struct VarDeclStatement : Statement {
-   VarDeclStatement(std::vector<VarDeclFragment*> varDecls, Type type, 
-         ASTNode* parent = nullptr)
-      :Statement{parent}, m_varDecls{varDecls}, m_type{type} {}
+   VarDeclStatement(std::vector<VarDeclFragment*> varDecls, Type type)
+      :Statement{NodeKind::VAR_DECL_STATEMENT}, m_varDecls{varDecls}, m_type{type} {}
 
    ~VarDeclStatement();
 
@@ -317,32 +645,31 @@ private:
 
 //------------------------------------------------------------------------------------
 
+// A row of an AssertBlock, e.g. made on the stack by a printer going through it
 struct AssertStatement : Statement {
-   AssertStatement(const std::string& methodName, const std::vector<int>& parameters,
-         const int result, ASTNode* parent = nullptr) 
-   :Statement{parent}, m_methodName{methodName}, m_params{parameters}, m_res{result} {}
+   AssertStatement(const AssertBlock& block, unsigned row) 
+   :Statement{NodeKind::ASSERT_STATEMENT}, m_block{&block}, m_row{row} {}
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
-   const std::string& getMethodName() const { return m_methodName; }
-   const std::vector<int>& getParameters() const { return m_params; }
-   const int getResult() const { return m_res; }
+   const std::string& getMethodName() const { return m_block->getMethodName(); }
+   unsigned getArity() const { return m_block->getArity(); }
+   const int* getArgs() const { return m_block->getArgs(m_row); }
+   int getResult() const { return m_block->getResult(m_row); }
 private:
-   std::string m_methodName;
-   std::vector<int> m_params;
-   int m_res;
+   const AssertBlock* m_block;
+   unsigned m_row;
 };
 
 //------------------------------------------------------------------------------------
 
 struct Block : Statement {
-   Block(ASTNode* parent = nullptr)
-      :Statement{parent} {}
-   Block(const std::vector<Statement*>& statements, ASTNode* parent = nullptr)
-      :Statement{parent}, m_stmts{statements} {}
+   Block() :Statement{NodeKind::BLOCK} {}
+   Block(const std::vector<Statement*>& statements)
+      :Statement{NodeKind::BLOCK}, m_stmts{statements} {}
 
    // frees up memory on the heap
-   ~Block() { for (Statement* s : m_stmts) if (s) delete s; }
+   ~Block() { for (Statement* s : m_stmts) release(s); }
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
@@ -357,10 +684,10 @@ private:
 //------------------------------------------------------------------------------------
 
 struct ReturnStatement : Statement {
-   ReturnStatement(Expression* expression, ASTNode* parent = nullptr)
-      :Statement{parent}, m_expr{expression} {}
+   ReturnStatement(Expression* expression)
+      :Statement{NodeKind::RETURN_STATEMENT}, m_expr{expression} {}
 
-   ~ReturnStatement() { if (m_expr) delete m_expr; }
+   ~ReturnStatement() { release(m_expr); }
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); } 
 
@@ -375,8 +702,8 @@ private:
 //------------------------------------------------------------------------------------
 
 struct AssignmentStatement : Statement {
-   AssignmentStatement(Name* name, Expression* expression, ASTNode* parent = nullptr)
-      :Statement{parent}, m_name{name}, m_expr{expression} {}
+   AssignmentStatement(Name* name, Expression* expression)
+      :Statement{NodeKind::ASSIGNMENT_STATEMENT}, m_name{name}, m_expr{expression} {}
 
    ~AssignmentStatement();
 
@@ -393,8 +720,9 @@ private:
 
 struct IfStatement : Statement {
    IfStatement(Expression* expression, Statement* thenStatement,
-         Statement* elseStatement = nullptr, ASTNode* parent = nullptr)
-      :Statement{parent}, m_expr{expression}, m_thenStmt{thenStatement}, 
+         Statement* elseStatement = nullptr)
+      :Statement{NodeKind::IF_STATEMENT},
+      m_expr{expression}, m_thenStmt{thenStatement}, 
       m_elseStmt{elseStatement} {}
 
    ~IfStatement();
@@ -425,9 +753,9 @@ struct ForStatement : Statement {
    // a sequence of assignment expressions. Updaters should consist of a sequence of
    // statement-expressions. To do: add checks.
    ForStatement(std::vector<VarDeclFragment*> initializers, Expression* expression, 
-        std::vector<Expression*> updaters, Statement* bodyStatement, 
-        ASTNode* parent = nullptr)
-      :Statement{parent}, m_forInits{initializers}, m_expr{expression}, 
+        std::vector<Expression*> updaters, Statement* bodyStatement)
+      :Statement{NodeKind::FOR_STATEMENT},
+      m_forInits{initializers}, m_expr{expression}, 
       m_updaters{updaters}, m_body{bodyStatement} {}
 
    ~ForStatement();
@@ -448,22 +776,31 @@ private:
 //------------------------------------------------------------------------------------
 
 struct Name : Expression {
-   Name(const std::string& name, ASTNode* parent = nullptr)
-      :Expression{parent}, m_name{name} {}
+   Name(const std::string& name)
+      :Expression{NodeKind::NAME}, m_slot{SymbolTable::global().intern(name)} {}
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
-   const std::string& getName() const { return m_name; }
-   void setName(const std::string& name) { m_name = name; }
+   // The identifier is kept once, in the symbol table
+   const std::string& getName() const 
+   { 
+      return SymbolTable::global().getIdentifier(m_slot); 
+   }
+   // Index of this identifier in SymbolTable::global()
+   int getSlot() const { return m_slot; }
+   void setName(const std::string& name) 
+   { 
+      m_slot = SymbolTable::global().intern(name);
+   }
 private:
-   std::string m_name;
+   int m_slot;
 };
 
 //------------------------------------------------------------------------------------
 
 struct BooleanLiteral : Expression {
-   BooleanLiteral(const bool value, ASTNode* parent = nullptr)
-      :Expression{parent}, m_boolVal{value} {}
+   BooleanLiteral(const bool value)
+      :Expression{NodeKind::BOOLEAN_LITERAL}, m_boolVal{value} {}
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); } 
 
@@ -477,25 +814,27 @@ private:
 //------------------------------------------------------------------------------------
 
 struct NumberLiteral : Expression {
-   // should throw an exception if token isn't a string of digits (no floats for now)
-   NumberLiteral(const std::string& token, ASTNode* parent = nullptr)
-      :Expression{parent}, m_token{token} {}
+   NumberLiteral(const int value)
+      :Expression{NodeKind::NUMBER_LITERAL}, m_value{value} {}
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); } 
 
-   std::string getToken() { return m_token; }
+   int getValue() const { return m_value; }
+   // The literal as a program would have it, e.g. "-3"
+   std::string getToken() const { return std::to_string(m_value); }
 
-   void setToken(const std::string& token) { m_token = token; }
+   void setValue(const int value) { m_value = value; }
 private:
-   std::string m_token; 
+   int m_value;
 };
 
 //------------------------------------------------------------------------------------
 
 struct InfixExpression : Expression {
    InfixExpression(Expression* leftHand, const InfixOperator infixOperator, 
-         Expression* rightHand, ASTNode* parent = nullptr)
-      :Expression{parent}, m_leftHand{leftHand}, m_op{infixOperator}, 
+         Expression* rightHand)
+      :Expression{NodeKind::INFIX_EXPRESSION},
+      m_leftHand{leftHand}, m_op{infixOperator}, 
       m_rightHand{rightHand} {}
 
    ~InfixExpression();
@@ -518,11 +857,11 @@ private:
 //------------------------------------------------------------------------------------
 
 struct PostfixExpression : Expression {
-   PostfixExpression(Expression* leftHand, const PostfixOperator postfixOperator,
-         ASTNode* parent = nullptr)
-      :Expression{parent}, m_leftHand{leftHand}, m_op{postfixOperator} {}
+   PostfixExpression(Expression* leftHand, const PostfixOperator postfixOperator)
+      :Expression{NodeKind::POSTFIX_EXPRESSION},
+      m_leftHand{leftHand}, m_op{postfixOperator} {}
 
-   ~PostfixExpression() { if (m_leftHand) delete m_leftHand; }
+   ~PostfixExpression() { release(m_leftHand); }
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
@@ -536,9 +875,11 @@ private:
 //------------------------------------------------------------------------------------
 
 struct VarDeclFragment : Expression {
-   VarDeclFragment(Name* name, Expression* expression, Type type, 
-         ASTNode* parent = nullptr)
-      :Expression{parent}, m_leftHand{name}, m_rightHand{expression}, m_type{type} {}
+   VarDeclFragment(Name* name, Expression* expression, Type type)
+      :Expression{NodeKind::VAR_DECL_FRAGMENT},
+      m_leftHand{name}, m_rightHand{expression}, m_type{type} {}
+
+   ~VarDeclFragment();
 
    void accept(ASTVisitor* visitor) { visitor->visit(this); }
 
@@ -553,8 +894,490 @@ private:
 
 //------------------------------------------------------------------------------------
 
-struct JavaPrinter : Printer {
-   JavaPrinter() :Printer{"\t"} {}
+// Calls visitor.visit(static_cast<T*>(node)) directly, not virtually
+template <typename Visitor, typename T> 
+void visitAs(ASTNode* node, Visitor& visitor)
+{
+   visitor.Visitor::visit(static_cast<T*>(node));
+}
+
+//------------------------------------------------------------------------------------
+
+// Calls visitor.visit(node) for the subclass node is, through a table indexed
+// by its kind. That is one indirect call, where node->accept(&visitor) makes
+// two virtual ones. Visitor can be any class with the 16 visit()s, ASTVisitor
+// or not. (A switch with the visits inlined into it was tried too, but made
+// visitors' code bigger and slower than accept().)
+template <typename Visitor> void dispatch(ASTNode* node, Visitor& visitor)
+{
+   typedef void (*Visit)(ASTNode*, Visitor&);
+   // In the order of NodeKind
+   static const Visit visits[]{
+      visitAs<Visitor, TesterBoilerplate>, visitAs<Visitor, Boilerplate>,
+      visitAs<Visitor, MethodDeclaration>, visitAs<Visitor, VarDeclStatement>,
+      visitAs<Visitor, AssertStatement>, visitAs<Visitor, Block>,
+      visitAs<Visitor, ReturnStatement>, visitAs<Visitor, AssignmentStatement>,
+      visitAs<Visitor, IfStatement>, visitAs<Visitor, ForStatement>,
+      visitAs<Visitor, Name>, visitAs<Visitor, BooleanLiteral>,
+      visitAs<Visitor, NumberLiteral>, visitAs<Visitor, InfixExpression>,
+      visitAs<Visitor, PostfixExpression>, visitAs<Visitor, VarDeclFragment>
+   };
+   visits[static_cast<int>(node->getKind())](node, visitor);
+}
+
+//------------------------------------------------------------------------------------
+
+// Child i of node, in the order printers visit them: for a for statement that
+// is its initializers, condition, updaters and body. Returns nullptr for an i
+// past the last child, and for the else of an if-statement without one. Names,
+// literals, testers and asserts have no children.
+inline ASTNode* childOf(TesterBoilerplate* tester, unsigned i) { return nullptr; }
+inline ASTNode* childOf(AssertStatement* assert, unsigned i) { return nullptr; }
+inline ASTNode* childOf(Name* name, unsigned i) { return nullptr; }
+inline ASTNode* childOf(BooleanLiteral* literal, unsigned i) { return nullptr; }
+inline ASTNode* childOf(NumberLiteral* literal, unsigned i) { return nullptr; }
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(Boilerplate* boilerplate, unsigned i)
+{
+   std::vector<Declaration*>& declarations = boilerplate->getBodyDeclarations();
+   return i < declarations.size() ? declarations[i] : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(MethodDeclaration* methodDeclaration, unsigned i)
+{
+   return i == 0 ? methodDeclaration->getBody() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(VarDeclStatement* varDeclStatement, unsigned i)
+{
+   const std::vector<VarDeclFragment*>& fragments = varDeclStatement->getFragments();
+   return i < fragments.size() ? fragments[i] : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(Block* block, unsigned i)
+{
+   const std::vector<Statement*>& statements = block->getStatements();
+   return i < statements.size() ? statements[i] : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(ReturnStatement* returnStatement, unsigned i)
+{
+   return i == 0 ? returnStatement->getExpression() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(AssignmentStatement* assignmentStatement, unsigned i)
+{
+   if (i == 0) return assignmentStatement->getName();
+   return i == 1 ? assignmentStatement->getExpression() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(IfStatement* ifStatement, unsigned i)
+{
+   if (i == 0) return ifStatement->getExpression();
+   if (i == 1) return ifStatement->getThenStatement();
+   return i == 2 ? ifStatement->getElseStatement() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(ForStatement* forStatement, unsigned i)
+{
+   const unsigned numberInits = forStatement->getInitializers().size();
+   const unsigned numberUpdaters = forStatement->getUpdaters().size();
+   if (i < numberInits) return forStatement->getInitializers()[i];
+   if (i == numberInits) return forStatement->getExpression();
+   if (i <= numberInits + numberUpdaters) 
+      return forStatement->getUpdaters()[i - numberInits - 1];
+   return i == numberInits + numberUpdaters + 1 ? forStatement->getBody() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(InfixExpression* infixExpression, unsigned i)
+{
+   if (i == 0) return infixExpression->getLeftOperand();
+   return i == 1 ? infixExpression->getRightOperand() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(PostfixExpression* postfixExpression, unsigned i)
+{
+   return i == 0 ? postfixExpression->getLeftOperand() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+inline ASTNode* childOf(VarDeclFragment* varDeclFragment, unsigned i)
+{
+   if (i == 0) return varDeclFragment->getLeftOperand();
+   return i == 1 ? varDeclFragment->getRightOperand() : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+// For a node of any class
+inline ASTNode* childOf(ASTNode* node, unsigned i)
+{
+   switch (node->getKind()) {
+      case NodeKind::TESTER_BOILERPLATE:
+         return childOf(static_cast<TesterBoilerplate*>(node), i);
+      case NodeKind::BOILERPLATE:
+         return childOf(static_cast<Boilerplate*>(node), i);
+      case NodeKind::METHOD_DECLARATION:
+         return childOf(static_cast<MethodDeclaration*>(node), i);
+      case NodeKind::VAR_DECL_STATEMENT:
+         return childOf(static_cast<VarDeclStatement*>(node), i);
+      case NodeKind::ASSERT_STATEMENT:
+         return childOf(static_cast<AssertStatement*>(node), i);
+      case NodeKind::BLOCK:
+         return childOf(static_cast<Block*>(node), i);
+      case NodeKind::RETURN_STATEMENT:
+         return childOf(static_cast<ReturnStatement*>(node), i);
+      case NodeKind::ASSIGNMENT_STATEMENT:
+         return childOf(static_cast<AssignmentStatement*>(node), i);
+      case NodeKind::IF_STATEMENT:
+         return childOf(static_cast<IfStatement*>(node), i);
+      case NodeKind::FOR_STATEMENT:
+         return childOf(static_cast<ForStatement*>(node), i);
+      case NodeKind::NAME:
+         return childOf(static_cast<Name*>(node), i);
+      case NodeKind::BOOLEAN_LITERAL:
+         return childOf(static_cast<BooleanLiteral*>(node), i);
+      case NodeKind::NUMBER_LITERAL:
+         return childOf(static_cast<NumberLiteral*>(node), i);
+      case NodeKind::INFIX_EXPRESSION:
+         return childOf(static_cast<InfixExpression*>(node), i);
+      case NodeKind::POSTFIX_EXPRESSION:
+         return childOf(static_cast<PostfixExpression*>(node), i);
+      case NodeKind::VAR_DECL_FRAGMENT:
+         return childOf(static_cast<VarDeclFragment*>(node), i);
+   }
+   return nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+// Walks a tree, calling the hooks of Hooks, the class deriving from it, directly
+// (so that they can be inlined) with each node as its own class. Hooks can hide
+// any of:
+//    enter(node)            before node's children (pre-order)
+//    between(node, child)   after child number child, if another one follows
+//                           (in-order, e.g. for printing an infix operator)
+//    leave(node)            after node's children (post-order)
+//    nextChild(node, child) the child of node to visit after child number
+//                           child, setting child to its number, or nullptr to
+//                           leave node. It is child + 1 unless a hook says
+//                           otherwise, e.g. to leave out a child, or to go back
+//                           to one to run a loop.
+// for any classes of node, with a using-declaration for the rest. Child numbers
+// are those of childOf(). A leave() hook calling stop() ends the walk: no hook
+// is called after it returns.
+//
+// The first MAX_RECURSION levels are walked recursively, since calls and returns
+// are better predicted than the steps of a loop over a stack, which made walking
+// typical trees two to three times slower. Deeper subtrees are walked without
+// recursion, keeping the path to the node the walk is at on a stack of its own,
+// so that trees of any depth can be walked.
+template <typename Hooks> class TreeWalker {
+public:
+   // Passed to nextChild() before the first child
+   static const int NO_CHILD{-1};
+   static const unsigned MAX_RECURSION{256};
+
+   void walk(ASTNode* root);
+   void stop() { m_stopped = true; }
+
+   template <typename T> void enter(T* node) {}
+   template <typename T> void between(T* node, int child) {}
+   template <typename T> void leave(T* node) {}
+   template <typename T> ASTNode* nextChild(T* node, int& child) {
+      return childOf(node, ++child);
+   }
+private:
+   struct Frame {
+      ASTNode* node;
+      int child; // the child being visited, or last visited
+   };
+
+   // Walks node from a table of functions, as dispatch() does, rather than a
+   // switch, so that each place walking a child has its own (better predicted)
+   // indirect call
+   void walk(ASTNode* node, unsigned depth) {
+      m_walks[static_cast<int>(node->getKind())](*this, node, depth);
+   }
+   // Walks node, a T, recursively
+   template <typename T> 
+   static void walkAs(TreeWalker& walker, ASTNode* node, unsigned depth);
+   void walkIteratively(ASTNode* node);
+   void start(ASTNode* node);
+   template <typename T> void start(T* node);
+   template <typename T> void step(T* node);
+
+   typedef void (*Walk)(TreeWalker&, ASTNode*, unsigned);
+   static const Walk m_walks[];
+
+   std::vector<Frame> m_path;
+   bool m_stopped{false};
+};
+
+//------------------------------------------------------------------------------------
+
+template <typename Hooks> void TreeWalker<Hooks>::walk(ASTNode* root)
+{
+   m_stopped = false;
+   walk(root, 0);
+}
+
+//------------------------------------------------------------------------------------
+
+// In the order of NodeKind
+template <typename Hooks> 
+const typename TreeWalker<Hooks>::Walk TreeWalker<Hooks>::m_walks[]{
+   walkAs<TesterBoilerplate>, walkAs<Boilerplate>, walkAs<MethodDeclaration>,
+   walkAs<VarDeclStatement>, walkAs<AssertStatement>, walkAs<Block>,
+   walkAs<ReturnStatement>, walkAs<AssignmentStatement>, walkAs<IfStatement>,
+   walkAs<ForStatement>, walkAs<Name>, walkAs<BooleanLiteral>,
+   walkAs<NumberLiteral>, walkAs<InfixExpression>, walkAs<PostfixExpression>,
+   walkAs<VarDeclFragment>
+};
+
+//------------------------------------------------------------------------------------
+
+template <typename Hooks> template <typename T> 
+void TreeWalker<Hooks>::walkAs(TreeWalker& walker, ASTNode* node, unsigned depth)
+{
+   Hooks& hooks = static_cast<Hooks&>(walker);
+   T* typedNode{static_cast<T*>(node)};
+   hooks.enter(typedNode);
+   int child{NO_CHILD};
+   int previous{NO_CHILD};
+   for (;;) {
+      ASTNode* next{hooks.nextChild(typedNode, child)};
+      if (!next) break;
+      if (previous != NO_CHILD) hooks.between(typedNode, previous);
+      previous = child;
+      if (depth < MAX_RECURSION) walker.walk(next, depth + 1);
+      else walker.walkIteratively(next);
+      if (walker.m_stopped) return;
+   }
+   hooks.leave(typedNode);
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Hooks> void TreeWalker<Hooks>::walkIteratively(ASTNode* node)
+{
+   m_path.clear();
+   start(node);
+   // One switch on the kind of node per step, with the hooks for it inlined
+   while (!m_path.empty() && !m_stopped) {
+      node = m_path.back().node;
+      switch (node->getKind()) {
+         case NodeKind::TESTER_BOILERPLATE:
+            step(static_cast<TesterBoilerplate*>(node));
+            break;
+         case NodeKind::BOILERPLATE:
+            step(static_cast<Boilerplate*>(node));
+            break;
+         case NodeKind::METHOD_DECLARATION:
+            step(static_cast<MethodDeclaration*>(node));
+            break;
+         case NodeKind::VAR_DECL_STATEMENT:
+            step(static_cast<VarDeclStatement*>(node));
+            break;
+         case NodeKind::ASSERT_STATEMENT:
+            step(static_cast<AssertStatement*>(node));
+            break;
+         case NodeKind::BLOCK:
+            step(static_cast<Block*>(node));
+            break;
+         case NodeKind::RETURN_STATEMENT:
+            step(static_cast<ReturnStatement*>(node));
+            break;
+         case NodeKind::ASSIGNMENT_STATEMENT:
+            step(static_cast<AssignmentStatement*>(node));
+            break;
+         case NodeKind::IF_STATEMENT:
+            step(static_cast<IfStatement*>(node));
+            break;
+         case NodeKind::FOR_STATEMENT:
+            step(static_cast<ForStatement*>(node));
+            break;
+         case NodeKind::INFIX_EXPRESSION:
+            step(static_cast<InfixExpression*>(node));
+            break;
+         case NodeKind::POSTFIX_EXPRESSION:
+            step(static_cast<PostfixExpression*>(node));
+            break;
+         case NodeKind::VAR_DECL_FRAGMENT:
+            step(static_cast<VarDeclFragment*>(node));
+            break;
+         default: // names and literals are never on the path
+            break;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+// Goes on to the next child of node, or leaves node if there isn't one
+template <typename Hooks> template <typename T> void TreeWalker<Hooks>::step(T* node)
+{
+   Hooks& hooks = static_cast<Hooks&>(*this);
+   Frame& frame = m_path.back();
+   int next{frame.child};
+   ASTNode* child{hooks.nextChild(node, next)};
+   if (!child) {
+      m_path.pop_back();
+      hooks.leave(node);
+      return;
+   }
+   if (frame.child != NO_CHILD) hooks.between(node, frame.child);
+   frame.child = next;
+   start(child);
+}
+
+//------------------------------------------------------------------------------------
+
+// Enters node. Names and literals, which have no children, are left at once
+// rather than put on the path.
+template <typename Hooks> void TreeWalker<Hooks>::start(ASTNode* node)
+{
+   Hooks& hooks = static_cast<Hooks&>(*this);
+   switch (node->getKind()) {
+      case NodeKind::TESTER_BOILERPLATE:
+         start(static_cast<TesterBoilerplate*>(node));
+         break;
+      case NodeKind::BOILERPLATE:
+         start(static_cast<Boilerplate*>(node));
+         break;
+      case NodeKind::METHOD_DECLARATION:
+         start(static_cast<MethodDeclaration*>(node));
+         break;
+      case NodeKind::VAR_DECL_STATEMENT:
+         start(static_cast<VarDeclStatement*>(node));
+         break;
+      case NodeKind::ASSERT_STATEMENT:
+         start(static_cast<AssertStatement*>(node));
+         break;
+      case NodeKind::BLOCK:
+         start(static_cast<Block*>(node));
+         break;
+      case NodeKind::RETURN_STATEMENT:
+         start(static_cast<ReturnStatement*>(node));
+         break;
+      case NodeKind::ASSIGNMENT_STATEMENT:
+         start(static_cast<AssignmentStatement*>(node));
+         break;
+      case NodeKind::IF_STATEMENT:
+         start(static_cast<IfStatement*>(node));
+         break;
+      case NodeKind::FOR_STATEMENT:
+         start(static_cast<ForStatement*>(node));
+         break;
+      case NodeKind::NAME:
+         hooks.enter(static_cast<Name*>(node));
+         hooks.leave(static_cast<Name*>(node));
+         break;
+      case NodeKind::BOOLEAN_LITERAL:
+         hooks.enter(static_cast<BooleanLiteral*>(node));
+         hooks.leave(static_cast<BooleanLiteral*>(node));
+         break;
+      case NodeKind::NUMBER_LITERAL:
+         hooks.enter(static_cast<NumberLiteral*>(node));
+         hooks.leave(static_cast<NumberLiteral*>(node));
+         break;
+      case NodeKind::INFIX_EXPRESSION:
+         start(static_cast<InfixExpression*>(node));
+         break;
+      case NodeKind::POSTFIX_EXPRESSION:
+         start(static_cast<PostfixExpression*>(node));
+         break;
+      case NodeKind::VAR_DECL_FRAGMENT:
+         start(static_cast<VarDeclFragment*>(node));
+         break;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Hooks> template <typename T> 
+void TreeWalker<Hooks>::start(T* node)
+{
+   static_cast<Hooks&>(*this).enter(node);
+   m_path.push_back(Frame{node, NO_CHILD});
+}
+
+//------------------------------------------------------------------------------------
+
+// Makes expressions that are structurally equal the same node, so that e.g.
+// every "n" or "0" a run builds is one Name or NumberLiteral. The nodes are
+// shared (see NodeArena), so they mustn't be changed, and the factory deletes
+// them when it goes. Operands passed to it must have come from it. Statements
+// aren't shared, since evaluators tell return statements apart by address.
+// Like the symbol table, only one thread at a time can make nodes with it.
+class NodeFactory {
+public:
+   static NodeFactory& global();
+
+   NodeFactory() :m_arena{64 * 1024, true} {}
+   NodeFactory(const NodeFactory&) = delete;
+   NodeFactory& operator=(const NodeFactory&) = delete;
+   ~NodeFactory();
+
+   Name* name(const std::string& identifier);
+   NumberLiteral* number(int value);
+   BooleanLiteral* boolean(bool value);
+   InfixExpression* infix(Expression* left, InfixOperator op, Expression* right);
+   PostfixExpression* postfix(Expression* operand, PostfixOperator op);
+
+   // Nodes asked for, and the bytes they would have taken made one by one
+   unsigned long long numberRequests() const { return m_requests; }
+   unsigned long long numberRequestedBytes() const { return m_requestedBytes; }
+   // Nodes actually made, and their bytes
+   unsigned numberNodes() const { return m_nodes.size(); }
+   unsigned long long numberBytes() const { return m_bytes; }
+private:
+   template <typename T, typename Key, typename... Args>
+   T* find(std::map<Key, T*>& nodes, const Key& key, Args&&... args);
+
+   NodeArena m_arena;
+   std::vector<ASTNode*> m_nodes;
+   std::map<std::string, Name*> m_names;
+   std::map<int, NumberLiteral*> m_numbers;
+   std::map<bool, BooleanLiteral*> m_booleans;
+   std::map<std::tuple<Expression*, InfixOperator, Expression*>, InfixExpression*>
+      m_infixes;
+   std::map<std::pair<Expression*, PostfixOperator>, PostfixExpression*> m_postfixes;
+   unsigned long long m_requests{0};
+   unsigned long long m_requestedBytes{0};
+   unsigned long long m_bytes{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// Prints programs and testers in Language. The visits are written once, for the
+// languages that look like C; others print what they write their own way by
+// specialising those visits (see LanguagePrinter.cpp, which instantiates it for
+// each language). Children are visited through dispatch(), so the visits of
+// each instantiation call each other directly.
+template <typename Language> struct LanguagePrinter : Printer {
+   LanguagePrinter() :Printer{"\t"} {}
 
    void visit(TesterBoilerplate* tester);
    void visit(Boilerplate* boilerplate);
@@ -566,7 +1389,7 @@ struct JavaPrinter : Printer {
    void visit(AssignmentStatement* assignmentStatement);
    void visit(IfStatement* ifStatement);
    void visit(ForStatement* forStatement);
-   void visit(Name* name) { *m_os << name->getName(); }
+   void visit(Name* name) { *m_out << name->getName(); }
    void visit(BooleanLiteral* booleanLiteral);
    void visit(NumberLiteral* numberLiteral);
    void visit(InfixExpression* infixExpression);
@@ -574,10 +1397,27 @@ struct JavaPrinter : Printer {
    void visit(VarDeclFragment* varDeclFragment);
 };
 
+template <> void LanguagePrinter<Java>::visit(TesterBoilerplate* tester);
+template <> void LanguagePrinter<Java>::visit(Boilerplate* boilerplate);
+template <> void LanguagePrinter<Java>::visit(MethodDeclaration* methodDeclaration);
+template <> void LanguagePrinter<Java>::visit(AssertStatement* assert);
+
+template <> void LanguagePrinter<JavaScript>::visit(TesterBoilerplate* tester);
+template <> void LanguagePrinter<JavaScript>::visit(Boilerplate* boilerplate);
+template <> void LanguagePrinter<JavaScript>::visit(
+      MethodDeclaration* methodDeclaration);
+template <> void LanguagePrinter<JavaScript>::visit(AssertStatement* assert);
+
+extern template struct LanguagePrinter<Java>;
+extern template struct LanguagePrinter<JavaScript>;
+
+typedef LanguagePrinter<Java> JavaPrinter;
+typedef LanguagePrinter<JavaScript> JavaScriptPrinter;
+
 //------------------------------------------------------------------------------------
 
-struct JavaScriptPrinter : Printer {
-   JavaScriptPrinter() :Printer{"\t"} {}
+struct SchemePrinter : Printer {
+   SchemePrinter() :Printer{"  "} {}
 
    void visit(TesterBoilerplate* tester);
    void visit(Boilerplate* boilerplate);
@@ -589,92 +1429,218 @@ struct JavaScriptPrinter : Printer {
    void visit(AssignmentStatement* assignmentStatement);
    void visit(IfStatement* ifStatement);
    void visit(ForStatement* forStatement);
-   void visit(Name* name) { *m_os << name->getName(); }
+   void visit(Name* name) { *m_out << name->getName(); }
    void visit(BooleanLiteral* booleanLiteral);
    void visit(NumberLiteral* numberLiteral);
    void visit(InfixExpression* infixExpression);
    void visit(PostfixExpression* postfixExpression);
    void visit(VarDeclFragment* varDeclFragment);
+private:
+   void leaveOpen(unsigned brackets);
+
+   // Brackets are left open because the AST here is constructed with lists of
+   // statements in a block, when really each statement in the same block should
+   // probably be a child of its subsequent statement: a let, or an if without an
+   // else, holds the rest of its block. This has the number of brackets left
+   // open in each block being printed, innermost last, which are closed where
+   // the block ends.
+   std::vector<unsigned> m_openBrackets;
 };
 
 //------------------------------------------------------------------------------------
 
-// Class to deal with missing brackets, which occur because the AST here is 
-// constructed with lists of statements in a block, when really each 
-// statement in the same block should probably be a child of its subsequent statement.
-struct MissingBracket : Printer {
-   MissingBracket() :Printer{"  "} {}
+struct HaskellPrinter : Printer {
+   HaskellPrinter() :Printer{"  "} {}
 
-   void visit(TesterBoilerplate* tester) {}
-   void visit(Boilerplate* boilerplate) {}
-   void visit(MethodDeclaration* methodDeclaration) {}
-   void visit(VarDeclStatement* varDeclStatement) { *m_os << ')'; }
-   void visit(AssertStatement* assert) {}
-   void visit(Block* block) {}
-   void visit(ReturnStatement* returnStatement) {}
-   void visit(AssignmentStatement* assignmentStatement) {}
+   void visit(TesterBoilerplate* tester);
+   void visit(Boilerplate* boilerplate);
+   void visit(MethodDeclaration* methodDeclaration);
+   void visit(VarDeclStatement* varDeclStatement);
+   void visit(AssertStatement* assert);
+   void visit(Block* block);
+   void visit(ReturnStatement* returnStatement);
+   void visit(AssignmentStatement* assignmentStatement);
    void visit(IfStatement* ifStatement);
-   void visit(ForStatement* forStatement) {}
-   void visit(Name* name) {}
-   void visit(BooleanLiteral* booleanLiteral) {}
-   void visit(NumberLiteral* numberLiteral) {}
-   void visit(InfixExpression* infixExpression) {}
-   void visit(PostfixExpression* postfixExpression) {}
-   void visit(VarDeclFragment* varDeclFragment) {}
+   void visit(ForStatement* forStatement);
+   void visit(Name* name) { *m_out << name->getName(); }
+   void visit(BooleanLiteral* booleanLiteral);
+   void visit(NumberLiteral* numberLiteral);
+   void visit(InfixExpression* infixExpression);
+   void visit(PostfixExpression* postfixExpression);
+   void visit(VarDeclFragment* varDeclFragment);
+private:
+   // Function application binds more tightly than any operator
+   static const int ARGUMENT_PRECEDENCE{10};
+
+   void printDagNode(const ExpressionDag& dag, int id,
+         const std::vector<std::string>& names, int outer);
+
+   std::vector<Name*> m_variables; // declared so far in the method
 };
 
 //------------------------------------------------------------------------------------
 
-struct SchemePrinter : Printer {
-   SchemePrinter() :Printer{"  "} {}
+struct ResultFinder : ASTVisitor {
+   ResultFinder(const std::vector<int>& inputs, 
+         const std::vector<std::string> inputNames);
 
-   void visit(TesterBoilerplate* tester);
+   void visit(TesterBoilerplate* tester) {} // Shouldn't be used
    void visit(Boilerplate* boilerplate);
    void visit(MethodDeclaration* methodDeclaration);
    void visit(VarDeclStatement* varDeclStatement);
-   void visit(AssertStatement* assert);
+   void visit(AssertStatement* assert) {} // Shouldn't be used
    void visit(Block* block);
    void visit(ReturnStatement* returnStatement);
    void visit(AssignmentStatement* assignmentStatement);
    void visit(IfStatement* ifStatement);
    void visit(ForStatement* forStatement);
-   void visit(Name* name) { *m_os << name->getName(); }
+   void visit(Name* name);
    void visit(BooleanLiteral* booleanLiteral);
    void visit(NumberLiteral* numberLiteral);
    void visit(InfixExpression* infixExpression);
    void visit(PostfixExpression* postfixExpression);
    void visit(VarDeclFragment* varDeclFragment);
+
+   int getResult() const { return m_res; }
+
+   // Declares the variable s with the value i; throws if s is already declared.
+   void addInput(const std::string& s, const int i);
+private:
+   void declare(int slot, int value);
+   bool isDeclared(int slot) const 
+   { 
+      return slot < static_cast<int>(m_declared.size()) && m_declared[slot]; 
+   }
+
+   int m_res{0};
+   // m_in and m_declared work as a simple Symbol Table, indexed by Name slot.
+   std::vector<int> m_in;
+   std::vector<char> m_declared;
+   // Slots in the order they were declared, so that a block's variables go out
+   // of scope at its end (and a loop body can declare them again)
+   std::vector<int> m_scope;
+
+   int m_compareSlot{-1};
+   int m_compareVal{0};
+   bool m_compare{false};
+   InfixOperator m_op{InfixOperator::LESS_EQUALS};
 };
 
 //------------------------------------------------------------------------------------
 
-struct HaskellPrinter : Printer {
-   HaskellPrinter() :Printer{"  "} {}
+// Instruction set of the register machine that BytecodeCompiler targets. The
+// JUMP_UNLESS_* forms fuse a comparison with the conditional branch that always
+// follows it in if-statements and for-loops.
+enum class OpCode : unsigned char {
+   LOAD_CONSTANT, // r[dst] = imm
+   MOVE,          // r[dst] = r[a]
+   ADD,           // r[dst] = r[a] + r[b]
+   MULTIPLY,      // r[dst] = r[a] * r[b]
+   LESS_EQUALS,   // r[dst] = r[a] <= r[b]
+   EQUALS,        // r[dst] = r[a] == r[b]
+   INCREMENT,     // ++r[dst]
+   DECREMENT,     // --r[dst]
+   JUMP,          // pc = imm
+   JUMP_IF_FALSE, // if (!r[a]) pc = imm
+   JUMP_UNLESS_LESS_EQUALS, // if (!(r[a] <= r[b])) pc = imm
+   JUMP_UNLESS_EQUALS,      // if (!(r[a] == r[b])) pc = imm
+   RETURN         // return r[a]
+};
 
-   void visit(TesterBoilerplate* tester);
+//------------------------------------------------------------------------------------
+
+struct Instruction {
+   OpCode op;
+   unsigned char dst, a, b;
+   int imm;
+};
+
+//------------------------------------------------------------------------------------
+
+// A compiled method. Registers 0 to numParams-1 hold the arguments in declaration
+// order, followed by the local variables and then temporaries.
+struct Bytecode {
+   std::vector<Instruction> code;
+   int numParams{0};
+   int numRegisters{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// Lowers the method of a Boilerplate into Bytecode once, so that it can be run
+// for many input vectors by a BytecodeVM without walking the tree again.
+struct BytecodeCompiler : ASTVisitor {
+   void visit(TesterBoilerplate* tester) {} // Shouldn't be used
    void visit(Boilerplate* boilerplate);
    void visit(MethodDeclaration* methodDeclaration);
    void visit(VarDeclStatement* varDeclStatement);
-   void visit(AssertStatement* assert);
+   void visit(AssertStatement* assert) {} // Shouldn't be used
    void visit(Block* block);
    void visit(ReturnStatement* returnStatement);
    void visit(AssignmentStatement* assignmentStatement);
    void visit(IfStatement* ifStatement);
    void visit(ForStatement* forStatement);
-   void visit(Name* name) { *m_os << name->getName(); }
+   void visit(Name* name);
    void visit(BooleanLiteral* booleanLiteral);
    void visit(NumberLiteral* numberLiteral);
    void visit(InfixExpression* infixExpression);
    void visit(PostfixExpression* postfixExpression);
    void visit(VarDeclFragment* varDeclFragment);
+
+   const Bytecode& getBytecode() const { return m_bytecode; }
+private:
+   void declare(int slot);
+   int registerOf(int slot) const;
+   int newRegister();
+   int compileExpression(Expression* expression);
+   // Emits a branch to a not-yet-known target and returns its index for patching
+   int emitBranchUnless(Expression* condition);
+   void emit(OpCode op, int dst, int a = 0, int b = 0, int imm = 0);
+
+   Bytecode m_bytecode;
+   bool m_compiledMethod{false};
+   // m_registerOf[slot] is the register of the variable with that Name slot, or
+   // -1. Registers 0 to m_numVariables-1 hold variables; those past the end are
+   // temporaries, which are released at the end of every statement.
+   std::vector<int> m_registerOf;
+   int m_numVariables{0};
+   int m_nextRegister{0};
+   int m_res{0}; // register holding the value of the last compiled expression
 };
 
 //------------------------------------------------------------------------------------
 
-struct ResultFinder : ASTVisitor {
-   ResultFinder(const std::vector<int>& inputs, 
-         const std::vector<std::string> inputNames, ASTNode* parent = nullptr)
-      :m_in{inputs}, m_inNames{inputNames} {}
+class BytecodeVM {
+public:
+   // Runs program with args bound to its parameters and returns the result.
+   int run(const Bytecode& program, const std::vector<int>& args);
+private:
+   std::vector<int> m_registers; // reused between runs
+};
+
+//------------------------------------------------------------------------------------
+
+// Number of input vectors that a BatchEvaluator evaluates together
+const int BATCH_LANES{8};
+
+// One int per lane. Conditions are held as masks: -1 in lanes where they are
+// true and 0 where they are false.
+struct Lanes {
+   int lane[BATCH_LANES];
+};
+
+//------------------------------------------------------------------------------------
+
+// Evaluates a program for BATCH_LANES input vectors at once. Every lane runs
+// through every statement, so if-statements become masked selects rather than
+// branches; the arithmetic uses AVX2 when the processor supports it.
+struct BatchEvaluator : ASTVisitor {
+   // inputs holds one array of BATCH_LANES values for each parameter of the
+   // program's method, in declaration order; results receives one per lane.
+   // If returnedBy isn't null it receives, for each lane, the return statement
+   // that lane's result came from.
+   void evaluate(Boilerplate* program, const std::vector<const int*>& inputs,
+         int* results, const ReturnStatement** returnedBy = nullptr);
 
    void visit(TesterBoilerplate* tester) {} // Shouldn't be used
    void visit(Boilerplate* boilerplate);
@@ -692,26 +1658,571 @@ struct ResultFinder : ASTVisitor {
    void visit(InfixExpression* infixExpression);
    void visit(PostfixExpression* postfixExpression);
    void visit(VarDeclFragment* varDeclFragment);
+private:
+   Lanes& variable(int slot);
+   void declare(int slot);
+   // Undeclares the variables declared since m_scope had scope entries
+   void leaveScope(std::size_t scope);
+
+   const std::vector<const int*>* m_inputs{nullptr};
+   // Variable values and declarations, indexed by Name slot
+   std::vector<Lanes> m_vars;
+   std::vector<char> m_declared;
+   // Slots of the declared variables, in the order they were declared, so that
+   // those declared in a block go out of scope at its end
+   std::vector<int> m_scope;
+
+   Lanes m_res;    // value of the last evaluated expression
+   Lanes m_active; // mask of the lanes executing the current statement
+   Lanes m_done;   // mask of the lanes that have returned
+   Lanes m_result; // returned values
+   const ReturnStatement* m_returnedBy[BATCH_LANES];
+};
+
+//------------------------------------------------------------------------------------
+
+// Evaluates program for numberInputs input vectors stored as one array per
+// parameter, BATCH_LANES at a time, and writes results[i] for input i.
+void evaluateBatches(Boilerplate* program, 
+      const std::vector<std::vector<int>>& inputs, unsigned numberInputs,
+      std::vector<int>& results);
 
-   const std::string& getResult() const { return m_res; }
+//------------------------------------------------------------------------------------
+
+// A flattened form of the A1/A2 programs: nested if-statements that compare
+// parameters against number literals with <= and return number literals. Each
+// parameter's literals split its range into cells, and the result for every
+// combination of cells is stored in one table, so a lookup is a few integer
+// comparisons per parameter and one array access.
+class DecisionTable {
+public:
+   // Returns false, leaving the table empty, if program isn't of that form.
+   bool build(Boilerplate* program);
+
+   // args holds one value per parameter, in declaration order.
+   int lookup(const int* args) const;
+   int lookup(const std::vector<int>& args) const { return lookup(args.data()); }
 
-   void addInput(const int i) { m_in.push_back(i); }
-   // Add check for uniqueness
-   void addInputName(const std::string& s) { m_inNames.push_back(s); }
+   unsigned numberCells() const { return m_outcomes.size(); }
+   // Index j holds the sorted literals that parameter j is compared to
+   const std::vector<std::vector<int>>& getThresholds() const 
+   { return m_thresholds; }
 private:
-   std::string m_res;
-   // m_in and m_inNames work as a simple Symbol Table.
-   std::vector<int> m_in;
-   std::vector<std::string> m_inNames;
+   bool addThresholds(Statement* statement);
 
-   std::string m_compareName;
-   int m_compareVal{0};
-   bool m_compare{false};
-   InfixOperator m_op{InfixOperator::LESS_EQUALS};
+   MethodDeclaration* m_method{nullptr};
+   // m_thresholds.at(j) holds the sorted literals that parameter j is compared to
+   std::vector<std::vector<int>> m_thresholds;
+   std::vector<unsigned> m_strides;
+   std::vector<int> m_outcomes;
+};
+
+//------------------------------------------------------------------------------------
+
+// Evaluates a program in 64-bit arithmetic, throwing BadSize if a value
+// overflows. For-loops of the form built by createRecurrenceBlock, i.e.
+//    for (int i = start; i <= bound; i++) { assignments }
+// where each assignment is linear in the variables assigned in the loop, are
+// not run iteration by iteration: the assignments are turned into a matrix,
+// which is raised to the number of iterations by repeated squaring, so the
+// n-th term costs O(log n). Any other loop is interpreted normally.
+struct RecurrenceEvaluator : ASTVisitor {
+   long long evaluate(Boilerplate* program, const std::vector<long long>& args);
+
+   void visit(TesterBoilerplate* tester) {} // Shouldn't be used
+   void visit(Boilerplate* boilerplate);
+   void visit(MethodDeclaration* methodDeclaration);
+   void visit(VarDeclStatement* varDeclStatement);
+   void visit(AssertStatement* assert) {} // Shouldn't be used
+   void visit(Block* block);
+   void visit(ReturnStatement* returnStatement);
+   void visit(AssignmentStatement* assignmentStatement);
+   void visit(IfStatement* ifStatement);
+   void visit(ForStatement* forStatement);
+   void visit(Name* name);
+   void visit(BooleanLiteral* booleanLiteral);
+   void visit(NumberLiteral* numberLiteral);
+   void visit(InfixExpression* infixExpression);
+   void visit(PostfixExpression* postfixExpression);
+   void visit(VarDeclFragment* varDeclFragment);
+private:
+   // Coefficients of the loop's variables, followed by a constant term
+   using LinearForm = std::vector<long long>;
+
+   bool runLinearLoop(ForStatement* forStatement);
+   bool toLinearForm(Expression* expression, int counter,
+         const std::vector<int>& state, const std::vector<LinearForm>& values,
+         LinearForm& form);
+   long long& variable(int slot);
+   void declare(int slot, long long value);
+
+   const std::vector<long long>* m_args{nullptr};
+   std::vector<long long> m_vars; // indexed by Name slot
+   std::vector<char> m_declared;
+   long long m_res{0};
+   bool m_returned{false};
+   long long m_result{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// Integer expressions as a directed acyclic graph in which structurally
+// identical subexpressions are a single node. Assignments can be added one after
+// another; a Name then stands for the node last assigned to its variable. So for
+// a block of assignments, valueOf() gives each variable's value after the block
+// in terms of the values before it, with anything computed twice shared.
+class ExpressionDag {
+public:
+   enum class Kind { VARIABLE, CONSTANT, INFIX };
+   struct Node {
+      Kind kind;
+      int value; // the slot of a VARIABLE, or the value of a CONSTANT
+      InfixOperator op;
+      int left, right; // operand nodes of an INFIX; always lower numbered
+   };
+
+   // Only names, number literals, + and * are allowed; anything else throws
+   // BadArgument.
+   int add(Expression* expression);
+   void assign(int slot, Expression* expression);
+   int valueOf(int slot);
+
+   const Node& getNode(int id) const { return m_nodes.at(id); }
+   int size() const { return m_nodes.size(); }
+   // uses[id] is set to the number of times node id is reached from roots,
+   // counting each of roots and each operand of a node reached for the first time
+   void countUses(const std::vector<int>& roots, std::vector<unsigned>& uses) const;
+private:
+   int addNode(const Node& node);
+
+   std::vector<Node> m_nodes;
+   std::map<std::vector<int>, int> m_ids; // node of each distinct key
+   std::vector<int> m_values; // node of each variable, by slot; -1 if none yet
 };
 
 //------------------------------------------------------------------------------------
 
+// A value computed by a program: an int, or a bool held as 1 or 0
+struct Value {
+   Value() {}
+   Value(Type type, int number) :type{type}, number{number} {}
+   static Value ofInt(int i) { return Value{Type::INT, i}; }
+   static Value ofBool(bool b) { return Value{Type::BOOL, b}; }
+
+   // Both throw BadArgument if the value has the other type
+   int asInt() const;
+   bool asBool() const;
+
+   Type type{Type::VOID};
+   int number{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// The state of one evaluation of a program. The program itself is only read, so
+// any number of frames, e.g. one per thread, can evaluate the same program at 
+// once. A frame can be reused for one evaluation after another. Arithmetic
+// wraps around like BytecodeVM's, and a return ends the method. The program is
+// walked by a TreeWalker, with the values of expressions on a stack, so that
+// neither deep nesting nor long chains of operators use up the call stack.
+struct EvaluationFrame : TreeWalker<EvaluationFrame> {
+   // args holds one value per parameter of program's method, in order
+   Value run(Boilerplate* program, const std::vector<int>& args);
+
+   // TreeWalker hooks. What is done on entering a node is done by nextChild(),
+   // when child is NO_CHILD.
+   using TreeWalker<EvaluationFrame>::nextChild;
+   using TreeWalker<EvaluationFrame>::leave;
+   ASTNode* nextChild(TesterBoilerplate* tester, int& child);
+   ASTNode* nextChild(MethodDeclaration* methodDeclaration, int& child);
+   ASTNode* nextChild(AssertStatement* assert, int& child);
+   ASTNode* nextChild(ReturnStatement* returnStatement, int& child);
+   void leave(ReturnStatement* returnStatement);
+   ASTNode* nextChild(AssignmentStatement* assignmentStatement, int& child);
+   void leave(AssignmentStatement* assignmentStatement);
+   ASTNode* nextChild(IfStatement* ifStatement, int& child);
+   ASTNode* nextChild(ForStatement* forStatement, int& child);
+   void leave(ForStatement* forStatement);
+   void leave(Name* name);
+   void leave(BooleanLiteral* booleanLiteral);
+   void leave(NumberLiteral* numberLiteral);
+   ASTNode* nextChild(InfixExpression* infixExpression, int& child);
+   void leave(InfixExpression* infixExpression);
+   ASTNode* nextChild(PostfixExpression* postfixExpression, int& child);
+   void leave(PostfixExpression* postfixExpression);
+   ASTNode* nextChild(VarDeclFragment* varDeclFragment, int& child);
+   void leave(VarDeclFragment* varDeclFragment);
+private:
+   // A for statement being run
+   struct Loop {
+      // The body as an ExpressionDag, if it only assigns ints (straightLine)
+      bool straightLine{false};
+      ExpressionDag step;
+      std::vector<int> assigned; // slots
+      std::vector<int> newValues; // node of each of assigned
+      std::vector<int> nodeValues;
+   };
+
+   void runStep(Loop& loop);
+   bool buildStep(Statement* body, ExpressionDag& step, std::vector<int>& assigned);
+   bool quick(Expression* expression, Value& value);
+   bool walks(Expression* expression);
+   Value apply(InfixExpression* infix);
+   Value apply(PostfixExpression* postfix);
+   static bool isLeaf(Expression* expression);
+   Value operand(Expression* expression);
+   Value pop();
+   Value& variable(int slot);
+   void declare(int slot, const Value& value);
+
+   const std::vector<int>* m_args{nullptr};
+   std::vector<Value> m_vars; // indexed by Name slot
+   std::vector<char> m_declared;
+   std::vector<Value> m_values; // of the expressions visited, not yet used
+   std::vector<Loop> m_loops; // innermost last
+   bool m_returned{false};
+   Value m_result;
+};
+
+//------------------------------------------------------------------------------------
+
+// Evaluates program on args in a frame of its own
+Value evaluate(Boilerplate* program, const std::vector<int>& args);
+
+//------------------------------------------------------------------------------------
+
+// Builds an optimised copy of a program, leaving the program itself as it was.
+// Variables whose values are known are replaced by them, infix expressions of 
+// literals are folded, if-statements with known conditions are replaced by the
+// branch that runs, and statements after a return are dropped. Given values for
+// the first parameters of the method, fold() also specialises it for them: they
+// are no longer parameters but local variables with those values.
+struct ConstantFolder : ASTVisitor {
+   Boilerplate* fold(Boilerplate* program, 
+         const std::vector<int>& fixedArgs = std::vector<int>{});
+
+   void visit(TesterBoilerplate* tester) {} // Shouldn't be used
+   void visit(Boilerplate* boilerplate);
+   void visit(MethodDeclaration* methodDeclaration);
+   void visit(VarDeclStatement* varDeclStatement);
+   void visit(AssertStatement* assert) {} // Shouldn't be used
+   void visit(Block* block);
+   void visit(ReturnStatement* returnStatement);
+   void visit(AssignmentStatement* assignmentStatement);
+   void visit(IfStatement* ifStatement);
+   void visit(ForStatement* forStatement);
+   void visit(Name* name);
+   void visit(BooleanLiteral* booleanLiteral);
+   void visit(NumberLiteral* numberLiteral);
+   void visit(InfixExpression* infixExpression);
+   void visit(PostfixExpression* postfixExpression);
+   void visit(VarDeclFragment* varDeclFragment);
+private:
+   // Each returns the folded copy, or nullptr for a statement that can go
+   Expression* fold(Expression* expression);
+   Statement* fold(Statement* statement);
+   VarDeclFragment* fold(VarDeclFragment* varDeclFragment);
+   void foldInto(Block* from, Block* to);
+   void setKnown(int slot, const Value& value);
+   void forget(int slot) { setKnown(slot, Value{}); }
+
+   const std::vector<int>* m_fixedArgs{nullptr};
+   // The value of each variable, by Name slot, where it is known; VOID otherwise
+   std::vector<Value> m_known;
+   // True once the statements folded so far are certain to return
+   bool m_returns{false};
+   Block* m_block{nullptr}; // the block being filled
+   unsigned m_loopDepth{0};
+   ASTNode* m_res{nullptr};
+};
+
+//------------------------------------------------------------------------------------
+
+// A program held as parallel arrays with an entry per node, in depth-first
+// order: a node's children come straight after it, and its subtree runs up to,
+// but not including, getEnd() of it. That makes it a fraction of the size of the
+// tree of ASTNodes and lets it be scanned from front to back. What getValue()
+// holds depends on the kind of node:
+//    BOILERPLATE                           index for getNames()
+//    METHOD_DECLARATION                    index for getMethod()
+//    VAR_DECL_STATEMENT, VAR_DECL_FRAGMENT the Type
+//    IF_STATEMENT                          1 if it has an else statement, or 0
+//    FOR_STATEMENT                         number of initializers
+//    NAME                                  slot in SymbolTable::global()
+//    BOOLEAN_LITERAL                       1 or 0
+//    NUMBER_LITERAL                        the number
+//    INFIX_EXPRESSION, POSTFIX_EXPRESSION  the operator
+// The children of a for statement are its initializers, its condition, its
+// updaters and its body. Test boilerplate and asserts have no flat form.
+class FlatTree {
+public:
+   struct Method {
+      std::string name;
+      std::vector<Parameter> params;
+      Type returnType;
+   };
+
+   FlatTree() {}
+   explicit FlatTree(Boilerplate* program);
+
+   // A new tree of ASTNodes that is the same as the program, for the caller to
+   // delete
+   Boilerplate* toAST() const;
+
+   std::uint32_t size() const { return m_kinds.size(); }
+   NodeKind getKind(std::uint32_t node) const { return m_kinds.at(node); }
+   int getValue(std::uint32_t node) const { return m_values.at(node); }
+   std::uint32_t getEnd(std::uint32_t node) const { return m_ends.at(node); }
+   // Children of a node are node + 1, getEnd(node + 1) and so on, up to getEnd(node)
+   unsigned numberChildren(std::uint32_t node) const;
+   const std::vector<std::string>& getNames(int i) const { return m_names.at(i); }
+   const Method& getMethod(int i) const { return m_methods.at(i); }
+   unsigned numberParams(int method) const 
+   { 
+      return getMethod(method).params.size(); 
+   }
+   // The symbol table slot of a method's parameter, -1 if it isn't interned
+   int getParamSlot(int method, unsigned i) const;
+private:
+   friend struct FlatTreeBuilder;
+
+   std::vector<NodeKind> m_kinds;
+   std::vector<int> m_values;
+   std::vector<std::uint32_t> m_ends;
+   std::vector<std::vector<std::string>> m_names;
+   std::vector<Method> m_methods;
+};
+
+//------------------------------------------------------------------------------------
+
+// Runs a flattened program like evaluate() runs a tree of ASTNodes
+Value evaluate(const FlatTree& program, const std::vector<int>& args);
+
+//------------------------------------------------------------------------------------
+
+// Writes program, and its tester if there is one, to a file that MappedProgram
+// loads. The nodes are laid out as in a FlatTree, but identifiers are written
+// as text, so the file can be loaded by a later run of the generator.
+void writeProgramFile(const boost::filesystem::path& path, Boilerplate* program,
+      TesterBoilerplate* tester = nullptr);
+
+//------------------------------------------------------------------------------------
+
+// The directory that keepProgramFile() writes under. It is empty, so that no
+// program files are written, unless it is set.
+void setProgramFileDirectory(const boost::filesystem::path& directory);
+
+// Writes program and its tester to <className>.ast in the program file
+// directory, at studentPath (e.g. 1234567/Java) within it, so that the files
+// handed out to students are kept apart from them. Does nothing if the program
+// file directory isn't set.
+void keepProgramFile(const boost::filesystem::path& studentPath, 
+      const std::string& className, Boilerplate* program, 
+      TesterBoilerplate* tester = nullptr);
+
+//------------------------------------------------------------------------------------
+
+// A program file written by writeProgramFile(), mapped into memory. Its nodes
+// are read from the mapping, as a FlatTree reads them from its arrays, so it
+// can be evaluated without making any ASTNodes. Loading it is one mmap(): the
+// sections of the file are pointed into, and the names in it are interned and
+// their text replaced by symbol table slots in the (private) mapping.
+// Throws BadPath if the file can't be mapped, BadArgument if it isn't a program
+// file of this VERSION, and BadSize if it is cut short or points out of range.
+class MappedProgram {
+public:
+   static const std::uint32_t VERSION{1};
+
+   explicit MappedProgram(const boost::filesystem::path& path);
+   ~MappedProgram();
+   MappedProgram(const MappedProgram&) = delete;
+   MappedProgram& operator=(const MappedProgram&) = delete;
+
+   // New trees of ASTNodes that are the same as the program and its tester, for
+   // the caller to delete. toTester() returns nullptr if the file has no tester.
+   Boilerplate* toAST() const;
+   TesterBoilerplate* toTester() const;
+
+   std::uint32_t size() const { return m_header->numberNodes; }
+   NodeKind getKind(std::uint32_t node) const 
+   { 
+      return static_cast<NodeKind>(m_kinds[checked(node)]); 
+   }
+   int getValue(std::uint32_t node) const { return m_values[checked(node)]; }
+   std::uint32_t getEnd(std::uint32_t node) const { return m_ends[checked(node)]; }
+   // As in FlatTree
+   unsigned numberChildren(std::uint32_t node) const;
+   std::vector<std::string> getNames(int i) const;
+   FlatTree::Method getMethod(int i) const;
+   unsigned numberParams(int method) const;
+   int getParamSlot(int method, unsigned i) const;
+   const char* getString(std::uint32_t i) const;
+private:
+   friend struct ProgramFileWriter;
+
+   // The file is these records, then the sections in the order of the pointers
+   // below. All but the kinds, which are bytes, are 4-byte words.
+   struct Header {
+      char magic[4];
+      std::uint32_t version;
+      std::uint32_t numberNodes, numberNameLists, numberNameIds, numberMethods,
+         numberParams, numberStrings, numberChars;
+      // The tester's package, class, method and name strings, if hasTester
+      std::uint32_t hasTester, testerStrings[4], arity, numberAsserts;
+   };
+   struct Method {
+      std::uint32_t name, returnType, firstParam, numberParams;
+   };
+   struct Param {
+      std::uint32_t type, name;
+      std::int32_t slot; // -1 in the file
+   };
+
+   std::uint32_t checked(std::uint32_t node) const;
+   void check() const;
+   void fixUp();
+
+   void* m_mapping{nullptr};
+   std::size_t m_length{0};
+   const Header* m_header{nullptr};
+   // Names' values are string indexes in the file, slots once fixed up
+   std::int32_t* m_values{nullptr};
+   const std::uint32_t* m_ends{nullptr};
+   // Name list i is m_nameIds[m_nameLists[i]] up to m_nameIds[m_nameLists[i+1]]
+   const std::uint32_t* m_nameLists{nullptr};
+   const std::uint32_t* m_nameIds{nullptr};
+   const Method* m_methods{nullptr};
+   Param* m_params{nullptr};
+   const std::int32_t* m_assertArgs{nullptr}; // row after row
+   const std::int32_t* m_assertResults{nullptr};
+   // String i is the null-terminated m_chars + m_strings[i]
+   const std::uint32_t* m_strings{nullptr};
+   const char* m_chars{nullptr};
+   const std::uint8_t* m_kinds{nullptr};
+};
+
+//------------------------------------------------------------------------------------
+
+// Runs a mapped program like evaluate() runs a FlatTree
+Value evaluate(const MappedProgram& program, const std::vector<int>& args);
+
+//------------------------------------------------------------------------------------
+
+// Works out the hash of a node, for ASTNode::hash(), from its kind, its
+// operator, literal, identifiers or types, and the hashes of its children
+// in order. Identifiers are hashed by their text rather than their slot, so a
+// hash is the same from run to run.
+struct StructuralHasher : ASTVisitor {
+   void visit(TesterBoilerplate* tester);
+   void visit(Boilerplate* boilerplate);
+   void visit(MethodDeclaration* methodDeclaration);
+   void visit(VarDeclStatement* varDeclStatement);
+   void visit(AssertStatement* assert);
+   void visit(Block* block);
+   void visit(ReturnStatement* returnStatement);
+   void visit(AssignmentStatement* assignmentStatement);
+   void visit(IfStatement* ifStatement);
+   void visit(ForStatement* forStatement);
+   void visit(Name* name);
+   void visit(BooleanLiteral* booleanLiteral);
+   void visit(NumberLiteral* numberLiteral);
+   void visit(InfixExpression* infixExpression);
+   void visit(PostfixExpression* postfixExpression);
+   void visit(VarDeclFragment* varDeclFragment);
+
+   std::uint64_t getHash() const { return m_hash; }
+   // Adds a value to the hash
+   void add(std::uint64_t value);
+   void add(const std::string& s);
+private:
+   void start(NodeKind kind);
+   void add(ASTNode* child);
+
+   std::uint64_t m_hash{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// The shape of a program, which is all that printing it depends on but the
+// values of its number literals: described, so that programs with the same
+// description print the same but for those values, and hashed, to find them
+// quickly. It also has the literals, in the order in which they are walked.
+struct ProgramShape : TreeWalker<ProgramShape> {
+   explicit ProgramShape(Boilerplate* program) { walk(program); }
+
+   std::uint64_t getHash() const { return m_hasher.getHash(); }
+   const std::string& getDescription() const { return m_description; }
+   const std::vector<NumberLiteral*>& getLiterals() const { return m_literals; }
+   std::vector<int> getNumbers() const;
+
+   template <typename T> void enter(T* node)
+   {
+      add(static_cast<std::uint64_t>(node->getKind()));
+      describe(node);
+   }
+   // Ends the node's children, so that the shape has the tree's structure
+   template <typename T> void leave(T* node) { add(LEAVE); }
+private:
+   static const std::uint64_t LEAVE{0xffffffffull};
+
+   // Adds a value to the description and the hash
+   void add(std::uint64_t value);
+   void add(const std::string& s);
+
+   template <typename T> void describe(T* node) {}
+   void describe(Boilerplate* boilerplate);
+   void describe(MethodDeclaration* methodDeclaration);
+   void describe(VarDeclStatement* varDeclStatement);
+   void describe(Name* name);
+   void describe(BooleanLiteral* booleanLiteral);
+   void describe(NumberLiteral* numberLiteral) 
+   { 
+      m_literals.push_back(numberLiteral); 
+   }
+   void describe(InfixExpression* infixExpression);
+   void describe(PostfixExpression* postfixExpression);
+   void describe(VarDeclFragment* varDeclFragment);
+
+   StructuralHasher m_hasher;
+   std::string m_description;
+   std::vector<NumberLiteral*> m_literals;
+};
+
+//------------------------------------------------------------------------------------
+
+// What a program does over a set of inputs
+struct SweepReport {
+   bool allReturnsReached() const;
+
+   unsigned long long numberInputs{0};
+   // Number of inputs giving each result
+   std::map<int, unsigned long long> histogram;
+   // The method's return statements in source order, the number of inputs that
+   // end at each, and the lexicographically first of those inputs (empty if
+   // there are none)
+   std::vector<const ReturnStatement*> returns;
+   std::vector<unsigned long long> returnHits;
+   std::vector<std::vector<int>> firstInputs;
+};
+
+//------------------------------------------------------------------------------------
+
+// Runs program on every input in [-range, range]^k, k being the number of
+// parameters of its method. The inputs are split between numberThreads threads
+// (0 for one per core) and evaluated BATCH_LANES at a time. If the program can
+// be made into a DecisionTable, each of its cells is evaluated once instead and
+// counted for the inputs it holds.
+SweepReport sweepInputDomain(Boilerplate* program, int range, 
+      unsigned numberThreads = 0);
+
+//------------------------------------------------------------------------------------
+
+// As above, for the first numberInputs inputs held one array per parameter
+SweepReport sweepInputs(Boilerplate* program, 
+      const std::vector<std::vector<int>>& inputs, unsigned numberInputs);
+
+//------------------------------------------------------------------------------------
+
 // To do: include error checking for successful directory creation.
 void makeDirectories(const std::string& studentNumber, const std::string& language);
 
@@ -784,8 +2295,22 @@ void printAssert_scm(const boost::filesystem::path& assertPath);
 
 //------------------------------------------------------------------------------------
 
-void printA1A2(Printer* myPrinter, const std::string& studentNumber, 
-      const std::string& language);
+// Writes A1 and A2, their testers and the tests' CSV files for the student
+template <typename Language> 
+void printA1A2(Printer* myPrinter, const std::string& studentNumber);
+
+//------------------------------------------------------------------------------------
+
+// The arguments of the A1/A2 tests are drawn from [-TEST_RANGE, TEST_RANGE]
+const int TEST_RANGE{100};
+
+//------------------------------------------------------------------------------------
+
+// Creates a random if-else tree program with method "cases". Trees with a return
+// statement that no argument in the test range reaches are drawn again, up to a
+// limit, after which BadSize is thrown.
+Boilerplate* createCasesProgram(const std::string& packageName, 
+      const std::string& className, const std::vector<Parameter>& params);
 
 //------------------------------------------------------------------------------------
 
@@ -802,17 +2327,20 @@ void createRecurrenceBlock(Block* myBlock);
 
 //------------------------------------------------------------------------------------
 
-void printA3(Printer* myPrinter, const std::string& studentNumber,
-      const std::string& language);
+template <typename Language> 
+void printA3(Printer* myPrinter, const std::string& studentNumber);
 
 //------------------------------------------------------------------------------------
 
+// extension is that of the tester's file, e.g. ".java"
 void printA1A2Tests(Printer* myPrinter, Boilerplate* myProgram, 
       const std::string& className, const std::string& methodName, 
-      const std::string& name, boost::filesystem::path studentPath);
+      const std::string& name, boost::filesystem::path studentPath,
+      const std::string& packageName, const std::string& extension);
 
 //------------------------------------------------------------------------------------
 
 void printA3Tests(Printer* myPrinter, Boilerplate* myProgram, 
       const std::string& className, const std::string& methodName,
-      const std::string& name, boost::filesystem::path studentPath);
+      const std::string& name, boost::filesystem::path studentPath,
+      const std::string& packageName, const std::string& extension);
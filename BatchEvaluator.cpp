@@ -0,0 +1,452 @@
+#include "AST.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define BATCH_HAVE_AVX2 0
+#endif
+
+// The lane-wise operations used by BatchEvaluator. Arithmetic wraps around like
+// the int arithmetic of ResultFinder, so results match it bit for bit.
+struct LaneOps {
+   void (*add)(const Lanes& a, const Lanes& b, Lanes& out);
+   void (*multiply)(const Lanes& a, const Lanes& b, Lanes& out);
+   void (*lessEquals)(const Lanes& a, const Lanes& b, Lanes& out);
+   void (*equals)(const Lanes& a, const Lanes& b, Lanes& out);
+   // out = mask ? a : b, lane by lane
+   void (*select)(const Lanes& mask, const Lanes& a, const Lanes& b, Lanes& out);
+};
+
+//------------------------------------------------------------------------------------
+
+static void addScalar(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i)
+      out.lane[i] = static_cast<int>(static_cast<unsigned>(a.lane[i]) +
+            static_cast<unsigned>(b.lane[i]));
+}
+
+//------------------------------------------------------------------------------------
+
+static void multiplyScalar(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i)
+      out.lane[i] = static_cast<int>(static_cast<unsigned>(a.lane[i]) *
+            static_cast<unsigned>(b.lane[i]));
+}
+
+//------------------------------------------------------------------------------------
+
+static void lessEqualsScalar(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i)
+      out.lane[i] = -(a.lane[i] <= b.lane[i]);
+}
+
+//------------------------------------------------------------------------------------
+
+static void equalsScalar(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i)
+      out.lane[i] = -(a.lane[i] == b.lane[i]);
+}
+
+//------------------------------------------------------------------------------------
+
+static void selectScalar(const Lanes& mask, const Lanes& a, const Lanes& b,
+      Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i)
+      out.lane[i] = (a.lane[i] & mask.lane[i]) | (b.lane[i] & ~mask.lane[i]);
+}
+
+//------------------------------------------------------------------------------------
+
+#if BATCH_HAVE_AVX2
+
+static_assert(BATCH_LANES == 8, "the AVX2 kernels work on 8 lanes of int");
+
+__attribute__((target("avx2")))
+static __m256i load(const Lanes& a)
+{
+   return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.lane));
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void store(__m256i v, Lanes& out)
+{
+   _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.lane), v);
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void addAvx2(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   store(_mm256_add_epi32(load(a), load(b)), out);
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void multiplyAvx2(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   store(_mm256_mullo_epi32(load(a), load(b)), out);
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void lessEqualsAvx2(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   // a <= b is !(a > b)
+   store(_mm256_xor_si256(_mm256_cmpgt_epi32(load(a), load(b)),
+            _mm256_set1_epi32(-1)), out);
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void equalsAvx2(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   store(_mm256_cmpeq_epi32(load(a), load(b)), out);
+}
+
+//------------------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void selectAvx2(const Lanes& mask, const Lanes& a, const Lanes& b,
+      Lanes& out)
+{
+   store(_mm256_blendv_epi8(load(b), load(a), load(mask)), out);
+}
+
+#endif
+
+//------------------------------------------------------------------------------------
+
+// Picks the AVX2 kernels if the processor we're running on has them
+static const LaneOps& laneOps()
+{
+   static const LaneOps scalarOps{addScalar, multiplyScalar, lessEqualsScalar,
+      equalsScalar, selectScalar};
+#if BATCH_HAVE_AVX2
+   static const LaneOps avx2Ops{addAvx2, multiplyAvx2, lessEqualsAvx2,
+      equalsAvx2, selectAvx2};
+   static const bool haveAvx2{__builtin_cpu_supports("avx2") != 0};
+   if (haveAvx2) return avx2Ops;
+#endif
+   return scalarOps;
+}
+
+//------------------------------------------------------------------------------------
+
+static void fill(Lanes& a, int value)
+{
+   for (int i=0; i<BATCH_LANES; ++i) a.lane[i] = value;
+}
+
+//------------------------------------------------------------------------------------
+
+static bool anyLane(const Lanes& mask)
+{
+   int any{0};
+   for (int i=0; i<BATCH_LANES; ++i) any |= mask.lane[i];
+   return any != 0;
+}
+
+//------------------------------------------------------------------------------------
+
+// Makes every lane that isn't 0 into -1, so that a condition can be used as a mask
+// by both the scalar select, which works bit by bit, and the AVX2 one, which looks
+// only at the top bit of each byte
+static void toMask(Lanes& a)
+{
+   for (int i=0; i<BATCH_LANES; ++i) a.lane[i] = -(a.lane[i] != 0);
+}
+
+//------------------------------------------------------------------------------------
+
+// a & ~b, lane by lane
+static void andNot(const Lanes& a, const Lanes& b, Lanes& out)
+{
+   for (int i=0; i<BATCH_LANES; ++i) out.lane[i] = a.lane[i] & ~b.lane[i];
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::evaluate(Boilerplate* program,
+      const std::vector<const int*>& inputs, int* results,
+      const ReturnStatement** returnedBy)
+{
+   m_inputs = &inputs;
+   m_vars.assign(SymbolTable::global().size(), Lanes{});
+   m_declared.assign(SymbolTable::global().size(), false);
+   fill(m_active, -1);
+   fill(m_done, 0);
+   fill(m_result, 0);
+   m_scope.clear();
+
+   program->accept(this);
+
+   // As with BytecodeVM, every input must reach a return statement
+   for (int i=0; i<BATCH_LANES; ++i)
+      if (!m_done.lane[i]) throw BadArgument{};
+   std::copy(m_result.lane, m_result.lane + BATCH_LANES, results);
+   if (returnedBy) std::copy(m_returnedBy, m_returnedBy + BATCH_LANES, returnedBy);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(Boilerplate* boilerplate)
+{
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      d->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(MethodDeclaration* methodDeclaration)
+{
+   const std::vector<Parameter>& params = methodDeclaration->getParamList();
+   if (params.size() != m_inputs->size()) throw BadSize{};
+   for (unsigned i=0; i<params.size(); ++i) {
+      int slot{SymbolTable::global().intern(params.at(i).name)};
+      declare(slot);
+      std::copy(m_inputs->at(i), m_inputs->at(i) + BATCH_LANES,
+            variable(slot).lane);
+   }
+   methodDeclaration->getBody()->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(VarDeclStatement* varDeclStatement)
+{
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      vdf->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(Block* block)
+{
+   std::size_t scope{m_scope.size()};
+   for (Statement* s : block->getStatements()) {
+      if (!anyLane(m_active)) break;
+      s->accept(this);
+   }
+   leaveScope(scope);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(ReturnStatement* returnStatement)
+{
+   returnStatement->getExpression()->accept(this);
+   laneOps().select(m_active, m_res, m_result, m_result);
+   // Lanes that have returned take no further part in the method
+   for (int i=0; i<BATCH_LANES; ++i) {
+      if (m_active.lane[i]) m_returnedBy[i] = returnStatement;
+      m_done.lane[i] |= m_active.lane[i];
+   }
+   fill(m_active, 0);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(AssignmentStatement* assignmentStatement)
+{
+   int slot{assignmentStatement->getName()->getSlot()};
+   Lanes& assignTo = variable(slot);
+   assignmentStatement->getExpression()->accept(this);
+   laneOps().select(m_active, m_res, assignTo, assignTo);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(IfStatement* ifStatement)
+{
+   Lanes active = m_active;
+   ifStatement->getExpression()->accept(this);
+   Lanes condition = m_res;
+   toMask(condition);
+
+   for (int i=0; i<BATCH_LANES; ++i)
+      m_active.lane[i] = active.lane[i] & condition.lane[i];
+   if (anyLane(m_active)) ifStatement->getThenStatement()->accept(this);
+
+   andNot(active, condition, m_active);
+   if (ifStatement->getElseStatement() && anyLane(m_active))
+      ifStatement->getElseStatement()->accept(this);
+
+   andNot(active, m_done, m_active);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(ForStatement* forStatement)
+{
+   for (Expression* e : forStatement->getInitializers())
+      e->accept(this);
+   Lanes active = m_active;
+   // Each lane leaves the loop once its condition is false; the loop ends when
+   // no lane is left in it.
+   for (;;) {
+      forStatement->getExpression()->accept(this);
+      toMask(m_res);
+      for (int i=0; i<BATCH_LANES; ++i) m_active.lane[i] &= m_res.lane[i];
+      if (!anyLane(m_active)) break;
+      forStatement->getBody()->accept(this);
+      for (Expression* e : forStatement->getUpdaters())
+         e->accept(this);
+      andNot(m_active, m_done, m_active);
+   }
+   andNot(active, m_done, m_active);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(Name* name)
+{
+   m_res = variable(name->getSlot());
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(BooleanLiteral* booleanLiteral)
+{
+   fill(m_res, booleanLiteral->booleanValue() ? -1 : 0);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(NumberLiteral* numberLiteral)
+{
+   fill(m_res, numberLiteral->getValue());
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(InfixExpression* infixExpression)
+{
+   infixExpression->getLeftOperand()->accept(this);
+   Lanes left = m_res;
+   infixExpression->getRightOperand()->accept(this);
+   const LaneOps& ops = laneOps();
+   switch (infixExpression->getOperator()) {
+      case InfixOperator::LESS_EQUALS:
+         ops.lessEquals(left, m_res, m_res);
+         break;
+      case InfixOperator::EQUALS:
+         ops.equals(left, m_res, m_res);
+         break;
+      case InfixOperator::PLUS:
+         ops.add(left, m_res, m_res);
+         break;
+      case InfixOperator::TIMES:
+         ops.multiply(left, m_res, m_res);
+         break;
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(PostfixExpression* postfixExpression)
+{
+   // Only variable++ or variable-- is supported
+   Name* name{dynamic_cast<Name*>(postfixExpression->getLeftOperand())};
+   if (!name) throw BadArgument{};
+   Lanes& operand = variable(name->getSlot());
+   Lanes step;
+   switch (postfixExpression->getOperator()) {
+      case PostfixOperator::INCREMENT:
+         fill(step, 1);
+         break;
+      case PostfixOperator::DECREMENT:
+         fill(step, -1);
+         break;
+      default:
+         throw BadArgument{};
+   }
+   Lanes updated;
+   laneOps().add(operand, step, updated);
+   laneOps().select(m_active, updated, operand, operand);
+   m_res = operand;
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::visit(VarDeclFragment* varDeclFragment)
+{
+   int slot{varDeclFragment->getLeftOperand()->getSlot()};
+   varDeclFragment->getRightOperand()->accept(this);
+   declare(slot);
+   laneOps().select(m_active, m_res, m_vars[slot], m_vars[slot]);
+}
+
+//------------------------------------------------------------------------------------
+
+Lanes& BatchEvaluator::variable(int slot)
+{
+   if (slot >= static_cast<int>(m_declared.size()) || !m_declared[slot])
+      throw BadArgument{};
+   return m_vars[slot];
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::declare(int slot)
+{
+   if (slot >= static_cast<int>(m_declared.size())) {
+      m_vars.resize(slot + 1);
+      m_declared.resize(slot + 1);
+   }
+   if (m_declared[slot]) throw BadArgument{};
+   m_declared[slot] = true;
+   m_scope.push_back(slot);
+}
+
+//------------------------------------------------------------------------------------
+
+void BatchEvaluator::leaveScope(std::size_t scope)
+{
+   for (; m_scope.size() > scope; m_scope.pop_back())
+      m_declared[m_scope.back()] = false;
+}
+
+//------------------------------------------------------------------------------------
+
+void evaluateBatches(Boilerplate* program,
+      const std::vector<std::vector<int>>& inputs, unsigned numberInputs,
+      std::vector<int>& results)
+{
+   for (const std::vector<int>& v : inputs)
+      if (v.size() < numberInputs) throw BadSize{};
+
+   results.resize(numberInputs);
+   BatchEvaluator evaluator;
+   std::vector<const int*> lanes(inputs.size());
+   std::vector<std::vector<int>> padded(inputs.size());
+   int batchResults[BATCH_LANES];
+   for (unsigned first=0; first < numberInputs; first += BATCH_LANES) {
+      unsigned count{std::min<unsigned>(BATCH_LANES, numberInputs - first)};
+      for (unsigned j=0; j<inputs.size(); ++j) {
+         if (count == BATCH_LANES) lanes.at(j) = inputs.at(j).data() + first;
+         else {
+            // The last, partial batch repeats its first input in the spare lanes
+            padded.at(j).assign(BATCH_LANES, inputs.at(j).at(first));
+            std::copy(inputs.at(j).begin() + first,
+                  inputs.at(j).begin() + first + count, padded.at(j).begin());
+            lanes.at(j) = padded.at(j).data();
+         }
+      }
+      evaluator.evaluate(program, lanes, batchResults);
+      std::copy(batchResults, batchResults + count, results.begin() + first);
+   }
+}
@@ -0,0 +1,239 @@
+#include "AST.h"
+
+void BytecodeCompiler::visit(Boilerplate* boilerplate)
+{
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      d->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(MethodDeclaration* methodDeclaration)
+{
+   // A Bytecode holds exactly one method
+   if (m_compiledMethod) throw BadSize{};
+   m_compiledMethod = true;
+
+   m_registerOf.assign(SymbolTable::global().size(), -1);
+   for (const Parameter& p : methodDeclaration->getParamList())
+      declare(SymbolTable::global().intern(p.name));
+   m_bytecode.numParams = m_numVariables;
+   m_nextRegister = m_numVariables;
+   m_bytecode.numRegisters = m_nextRegister;
+
+   methodDeclaration->getBody()->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(VarDeclStatement* varDeclStatement)
+{
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      vdf->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(Block* block)
+{
+   for (Statement* s : block->getStatements()) {
+      s->accept(this);
+      m_nextRegister = m_numVariables; // temporaries die with their statement
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(ReturnStatement* returnStatement)
+{
+   emit(OpCode::RETURN, 0, compileExpression(returnStatement->getExpression()));
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(AssignmentStatement* assignmentStatement)
+{
+   // Throws if we're not assigning to a variable already in the symbol table
+   int assignTo{registerOf(assignmentStatement->getName()->getSlot())};
+   int value{compileExpression(assignmentStatement->getExpression())};
+   if (value != assignTo) emit(OpCode::MOVE, assignTo, value);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(IfStatement* ifStatement)
+{
+   int branchToElse{emitBranchUnless(ifStatement->getExpression())};
+   ifStatement->getThenStatement()->accept(this);
+   if (ifStatement->getElseStatement()) {
+      int jumpToEnd{static_cast<int>(m_bytecode.code.size())};
+      emit(OpCode::JUMP, 0);
+      m_bytecode.code.at(branchToElse).imm = m_bytecode.code.size();
+      ifStatement->getElseStatement()->accept(this);
+      m_bytecode.code.at(jumpToEnd).imm = m_bytecode.code.size();
+   }
+   else m_bytecode.code.at(branchToElse).imm = m_bytecode.code.size();
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(ForStatement* forStatement)
+{
+   for (Expression* e : forStatement->getInitializers())
+      e->accept(this);
+   int condition{static_cast<int>(m_bytecode.code.size())};
+   int branchToEnd{emitBranchUnless(forStatement->getExpression())};
+   forStatement->getBody()->accept(this);
+   for (Expression* e : forStatement->getUpdaters())
+      compileExpression(e);
+   emit(OpCode::JUMP, 0, 0, 0, condition);
+   m_bytecode.code.at(branchToEnd).imm = m_bytecode.code.size();
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(Name* name)
+{
+   // Variables are read straight from their own register
+   m_res = registerOf(name->getSlot());
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(BooleanLiteral* booleanLiteral)
+{
+   m_res = newRegister();
+   emit(OpCode::LOAD_CONSTANT, m_res, 0, 0, booleanLiteral->booleanValue());
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(NumberLiteral* numberLiteral)
+{
+   // The token is parsed here once rather than on every evaluation
+   m_res = newRegister();
+   emit(OpCode::LOAD_CONSTANT, m_res, 0, 0, numberLiteral->getValue());
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(InfixExpression* infixExpression)
+{
+   int left{compileExpression(infixExpression->getLeftOperand())};
+   int right{compileExpression(infixExpression->getRightOperand())};
+   OpCode op;
+   switch (infixExpression->getOperator()) {
+      case InfixOperator::LESS_EQUALS:
+         op = OpCode::LESS_EQUALS;
+         break;
+      case InfixOperator::EQUALS:
+         op = OpCode::EQUALS;
+         break;
+      case InfixOperator::PLUS:
+         op = OpCode::ADD;
+         break;
+      case InfixOperator::TIMES:
+         op = OpCode::MULTIPLY;
+         break;
+      default:
+         throw BadArgument{};
+   }
+   m_res = newRegister();
+   emit(op, m_res, left, right);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(PostfixExpression* postfixExpression)
+{
+   // As in ResultFinder, only variable++ or variable-- is supported
+   int operand{compileExpression(postfixExpression->getLeftOperand())};
+   if (operand >= m_numVariables) throw BadArgument{};
+   switch (postfixExpression->getOperator()) {
+      case PostfixOperator::INCREMENT:
+         emit(OpCode::INCREMENT, operand);
+         break;
+      case PostfixOperator::DECREMENT:
+         emit(OpCode::DECREMENT, operand);
+         break;
+      default:
+         throw BadArgument{};
+   }
+   m_res = operand;
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::visit(VarDeclFragment* varDeclFragment)
+{
+   // The initializer may not refer to the variable being declared, so it is
+   // compiled before the variable is added to the symbol table.
+   int value{compileExpression(varDeclFragment->getRightOperand())};
+   int local{m_numVariables};
+   declare(varDeclFragment->getLeftOperand()->getSlot());
+   if (m_nextRegister <= local) newRegister();
+   if (value != local) emit(OpCode::MOVE, local, value);
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::declare(int slot)
+{
+   if (slot >= static_cast<int>(m_registerOf.size()))
+      m_registerOf.resize(slot + 1, -1);
+   if (m_registerOf[slot] != -1) throw BadArgument{};
+   m_registerOf[slot] = m_numVariables++;
+}
+
+//------------------------------------------------------------------------------------
+
+int BytecodeCompiler::registerOf(int slot) const
+{
+   if (slot >= static_cast<int>(m_registerOf.size()) || m_registerOf[slot] == -1)
+      throw BadArgument{};
+   return m_registerOf[slot];
+}
+
+//------------------------------------------------------------------------------------
+
+int BytecodeCompiler::newRegister()
+{
+   // Register numbers have to fit in an Instruction's unsigned char fields
+   if (m_nextRegister > 255) throw BadSize{};
+   if (m_nextRegister == m_bytecode.numRegisters) ++m_bytecode.numRegisters;
+   return m_nextRegister++;
+}
+
+//------------------------------------------------------------------------------------
+
+int BytecodeCompiler::compileExpression(Expression* expression)
+{
+   expression->accept(this);
+   return m_res;
+}
+
+//------------------------------------------------------------------------------------
+
+int BytecodeCompiler::emitBranchUnless(Expression* condition)
+{
+   InfixExpression* comparison{dynamic_cast<InfixExpression*>(condition)};
+   if (comparison && (comparison->getOperator() == InfixOperator::LESS_EQUALS ||
+            comparison->getOperator() == InfixOperator::EQUALS)) {
+      int left{compileExpression(comparison->getLeftOperand())};
+      int right{compileExpression(comparison->getRightOperand())};
+      emit(comparison->getOperator() == InfixOperator::LESS_EQUALS ?
+            OpCode::JUMP_UNLESS_LESS_EQUALS : OpCode::JUMP_UNLESS_EQUALS,
+            0, left, right);
+   }
+   else emit(OpCode::JUMP_IF_FALSE, 0, compileExpression(condition));
+   m_nextRegister = m_numVariables;
+   return m_bytecode.code.size() - 1;
+}
+
+//------------------------------------------------------------------------------------
+
+void BytecodeCompiler::emit(OpCode op, int dst, int a, int b, int imm)
+{
+   m_bytecode.code.push_back(Instruction{op, static_cast<unsigned char>(dst),
+         static_cast<unsigned char>(a), static_cast<unsigned char>(b), imm});
+}
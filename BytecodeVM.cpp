@@ -0,0 +1,74 @@
+#include "AST.h"
+
+// Integer overflow wraps around, as it did for ResultFinder's int arithmetic.
+static int wrapAdd(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+static int wrapMultiply(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+int BytecodeVM::run(const Bytecode& program, const std::vector<int>& args)
+{
+   if (static_cast<int>(args.size()) != program.numParams) throw BadSize{};
+   if (static_cast<int>(m_registers.size()) < program.numRegisters)
+      m_registers.resize(program.numRegisters);
+   std::copy(args.begin(), args.end(), m_registers.begin());
+
+   int* r{m_registers.data()};
+   const Instruction* code{program.code.data()};
+   const int size{static_cast<int>(program.code.size())};
+   for (int pc=0; pc<size; ++pc) {
+      const Instruction& in = code[pc];
+      switch (in.op) {
+         case OpCode::LOAD_CONSTANT:
+            r[in.dst] = in.imm;
+            break;
+         case OpCode::MOVE:
+            r[in.dst] = r[in.a];
+            break;
+         case OpCode::ADD:
+            r[in.dst] = wrapAdd(r[in.a], r[in.b]);
+            break;
+         case OpCode::MULTIPLY:
+            r[in.dst] = wrapMultiply(r[in.a], r[in.b]);
+            break;
+         case OpCode::LESS_EQUALS:
+            r[in.dst] = r[in.a] <= r[in.b];
+            break;
+         case OpCode::EQUALS:
+            r[in.dst] = r[in.a] == r[in.b];
+            break;
+         case OpCode::INCREMENT:
+            r[in.dst] = wrapAdd(r[in.dst], 1);
+            break;
+         case OpCode::DECREMENT:
+            r[in.dst] = wrapAdd(r[in.dst], -1);
+            break;
+         case OpCode::JUMP:
+            pc = in.imm - 1;
+            break;
+         case OpCode::JUMP_IF_FALSE:
+            if (!r[in.a]) pc = in.imm - 1;
+            break;
+         case OpCode::JUMP_UNLESS_LESS_EQUALS:
+            if (!(r[in.a] <= r[in.b])) pc = in.imm - 1;
+            break;
+         case OpCode::JUMP_UNLESS_EQUALS:
+            if (!(r[in.a] == r[in.b])) pc = in.imm - 1;
+            break;
+         case OpCode::RETURN:
+            return r[in.a];
+         default:
+            throw BadArgument{};
+      }
+   }
+   throw BadArgument{}; // fell off the end of the method without returning
+}
@@ -0,0 +1,489 @@
+#include "AST.h"
+
+// Integer overflow wraps around, as in BytecodeVM
+static int wrapAdd(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+static int wrapMultiply(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+// Returns false if expression isn't a literal
+static bool literalValue(Expression* expression, Value& value)
+{
+   if (NumberLiteral* number = dynamic_cast<NumberLiteral*>(expression)) {
+      value = Value::ofInt(number->getValue());
+      return true;
+   }
+   if (BooleanLiteral* boolean = dynamic_cast<BooleanLiteral*>(expression)) {
+      value = Value::ofBool(boolean->booleanValue());
+      return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------------
+
+static Expression* makeLiteral(const Value& value)
+{
+   if (value.type == Type::BOOL) return new BooleanLiteral{value.asBool()};
+   return new NumberLiteral{value.asInt()};
+}
+
+//------------------------------------------------------------------------------------
+
+static bool operator==(const Value& a, const Value& b)
+{
+   return a.type == b.type && a.number == b.number;
+}
+
+//------------------------------------------------------------------------------------
+
+// Adds the slot of every variable that node declares, assigns or increments
+static void addAssignedSlots(ASTNode* node, std::vector<int>& slots)
+{
+   if (Block* block = dynamic_cast<Block*>(node)) {
+      for (Statement* s : block->getStatements())
+         addAssignedSlots(s, slots);
+   }
+   else if (IfStatement* ifStatement = dynamic_cast<IfStatement*>(node)) {
+      addAssignedSlots(ifStatement->getThenStatement(), slots);
+      if (ifStatement->getElseStatement())
+         addAssignedSlots(ifStatement->getElseStatement(), slots);
+   }
+   else if (ForStatement* forStatement = dynamic_cast<ForStatement*>(node)) {
+      for (VarDeclFragment* vdf : forStatement->getInitializers())
+         addAssignedSlots(vdf, slots);
+      for (Expression* e : forStatement->getUpdaters())
+         addAssignedSlots(e, slots);
+      addAssignedSlots(forStatement->getBody(), slots);
+   }
+   else if (VarDeclStatement* varDeclStatement =
+         dynamic_cast<VarDeclStatement*>(node)) {
+      for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+         addAssignedSlots(vdf, slots);
+   }
+   else if (VarDeclFragment* vdf = dynamic_cast<VarDeclFragment*>(node))
+      slots.push_back(vdf->getLeftOperand()->getSlot());
+   else if (AssignmentStatement* assignmentStatement =
+         dynamic_cast<AssignmentStatement*>(node))
+      slots.push_back(assignmentStatement->getName()->getSlot());
+   else if (PostfixExpression* postfixExpression =
+         dynamic_cast<PostfixExpression*>(node)) {
+      if (Name* name = dynamic_cast<Name*>(postfixExpression->getLeftOperand()))
+         slots.push_back(name->getSlot());
+   }
+   else if (InfixExpression* infixExpression = dynamic_cast<InfixExpression*>(node)) {
+      addAssignedSlots(infixExpression->getLeftOperand(), slots);
+      addAssignedSlots(infixExpression->getRightOperand(), slots);
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+// Returns true if node has a Name with the given slot
+static bool mentions(ASTNode* node, int slot)
+{
+   if (!node) return false;
+   if (Name* name = dynamic_cast<Name*>(node)) return name->getSlot() == slot;
+   if (Block* block = dynamic_cast<Block*>(node))
+      return std::any_of(block->getStatements().begin(),
+            block->getStatements().end(),
+            [slot](Statement* s) { return mentions(s, slot); });
+   if (IfStatement* ifStatement = dynamic_cast<IfStatement*>(node))
+      return mentions(ifStatement->getExpression(), slot) ||
+         mentions(ifStatement->getThenStatement(), slot) ||
+         mentions(ifStatement->getElseStatement(), slot);
+   if (ForStatement* forStatement = dynamic_cast<ForStatement*>(node))
+      return std::any_of(forStatement->getInitializers().begin(),
+            forStatement->getInitializers().end(),
+            [slot](VarDeclFragment* vdf) { return mentions(vdf, slot); }) ||
+         mentions(forStatement->getExpression(), slot) ||
+         std::any_of(forStatement->getUpdaters().begin(),
+               forStatement->getUpdaters().end(),
+               [slot](Expression* e) { return mentions(e, slot); }) ||
+         mentions(forStatement->getBody(), slot);
+   if (VarDeclStatement* varDeclStatement = dynamic_cast<VarDeclStatement*>(node))
+      return std::any_of(varDeclStatement->getFragments().begin(),
+            varDeclStatement->getFragments().end(),
+            [slot](VarDeclFragment* vdf) { return mentions(vdf, slot); });
+   if (VarDeclFragment* vdf = dynamic_cast<VarDeclFragment*>(node))
+      return mentions(vdf->getLeftOperand(), slot) ||
+         mentions(vdf->getRightOperand(), slot);
+   if (ReturnStatement* returnStatement = dynamic_cast<ReturnStatement*>(node))
+      return mentions(returnStatement->getExpression(), slot);
+   if (AssignmentStatement* assignmentStatement =
+         dynamic_cast<AssignmentStatement*>(node))
+      return mentions(assignmentStatement->getName(), slot) ||
+         mentions(assignmentStatement->getExpression(), slot);
+   if (InfixExpression* infixExpression = dynamic_cast<InfixExpression*>(node))
+      return mentions(infixExpression->getLeftOperand(), slot) ||
+         mentions(infixExpression->getRightOperand(), slot);
+   if (PostfixExpression* postfixExpression = dynamic_cast<PostfixExpression*>(node))
+      return mentions(postfixExpression->getLeftOperand(), slot);
+   return false;
+}
+
+//------------------------------------------------------------------------------------
+
+Boilerplate* ConstantFolder::fold(Boilerplate* program,
+      const std::vector<int>& fixedArgs)
+{
+   m_fixedArgs = &fixedArgs;
+   m_known.assign(SymbolTable::global().size(), Value{});
+   m_returns = false;
+   program->accept(this);
+   return static_cast<Boilerplate*>(m_res);
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(Boilerplate* boilerplate)
+{
+   Boilerplate* folded{new Boilerplate{boilerplate->getNames()}};
+   for (Declaration* d : boilerplate->getBodyDeclarations()) {
+      d->accept(this);
+      folded->addDeclaration(static_cast<Declaration*>(m_res));
+   }
+   m_res = folded;
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(MethodDeclaration* methodDeclaration)
+{
+   const std::vector<Parameter>& params = methodDeclaration->getParamList();
+   if (m_fixedArgs->size() > params.size()) throw BadSize{};
+
+   std::vector<int> fixedSlots;
+   for (unsigned i=0; i<m_fixedArgs->size(); ++i) {
+      fixedSlots.push_back(SymbolTable::global().intern(params.at(i).name));
+      setKnown(fixedSlots.back(), Value::ofInt(m_fixedArgs->at(i)));
+   }
+   // Usually every use of a fixed parameter is folded away. The body is folded
+   // once to find out, and again after declaring the ones still used, e.g. 
+   // int n = 5;
+   std::vector<Value> known{m_known};
+   Block* body{new Block};
+   foldInto(methodDeclaration->getBody(), body);
+   std::vector<bool> used;
+   for (int slot : fixedSlots) used.push_back(mentions(body, slot));
+   if (std::find(used.begin(), used.end(), true) != used.end()) {
+      delete body;
+      body = new Block;
+      m_known = known;
+      m_returns = false;
+      for (unsigned i=0; i<fixedSlots.size(); ++i) {
+         if (!used.at(i)) continue;
+         const Parameter& p = params.at(i);
+         body->addStatement(new VarDeclStatement{{new VarDeclFragment{
+            new Name{p.name}, makeLiteral(m_known.at(fixedSlots.at(i))), p.type}},
+            p.type});
+      }
+      foldInto(methodDeclaration->getBody(), body);
+   }
+
+   std::vector<Parameter> remaining(params.begin() + m_fixedArgs->size(),
+         params.end());
+   m_res = new MethodDeclaration{body, methodDeclaration->getName(), remaining,
+      methodDeclaration->getReturnType()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(VarDeclStatement* varDeclStatement)
+{
+   std::vector<VarDeclFragment*> fragments;
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      fragments.push_back(fold(vdf));
+   m_res = new VarDeclStatement{fragments, varDeclStatement->getType()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(Block* block)
+{
+   Block* folded{new Block};
+   foldInto(block, folded);
+   m_res = folded;
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(ReturnStatement* returnStatement)
+{
+   m_res = new ReturnStatement{fold(returnStatement->getExpression())};
+   m_returns = true;
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(AssignmentStatement* assignmentStatement)
+{
+   Name* name{assignmentStatement->getName()};
+   Expression* expression{fold(assignmentStatement->getExpression())};
+   Value value;
+   if (literalValue(expression, value)) setKnown(name->getSlot(), value);
+   else forget(name->getSlot());
+   m_res = new AssignmentStatement{new Name{name->getName()}, expression};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(IfStatement* ifStatement)
+{
+   Expression* condition{fold(ifStatement->getExpression())};
+   Value value;
+   if (literalValue(condition, value)) {
+      delete condition;
+      Statement* taken{value.asBool() ? ifStatement->getThenStatement() :
+         ifStatement->getElseStatement()};
+      // The branch's statements join the enclosing block, unless they declare
+      // variables that would then clash with the block's own
+      Block* block{dynamic_cast<Block*>(taken)};
+      if (block && std::none_of(block->getStatements().begin(),
+               block->getStatements().end(), [](Statement* s) {
+                  return dynamic_cast<VarDeclStatement*>(s) != nullptr; })) {
+         foldInto(block, m_block);
+         m_res = nullptr;
+      }
+      else m_res = taken ? fold(taken) : nullptr;
+      return;
+   }
+
+   // Afterwards only the values that are the same along both branches are known
+   std::vector<Value> before{m_known};
+   Statement* thenStatement{fold(ifStatement->getThenStatement())};
+   if (!thenStatement) thenStatement = new Block;
+   bool thenReturns{m_returns};
+   std::vector<Value> afterThen{m_known};
+
+   m_known = before;
+   m_returns = false;
+   Statement* elseStatement{ifStatement->getElseStatement() ?
+      fold(ifStatement->getElseStatement()) : nullptr};
+   bool elseReturns{m_returns};
+   if (thenReturns && !elseReturns) afterThen = m_known;
+   else if (elseReturns && !thenReturns) m_known = afterThen;
+   afterThen.resize(m_known.size());
+   for (unsigned i=0; i<m_known.size(); ++i)
+      if (!(m_known[i] == afterThen[i])) m_known[i] = Value{};
+   m_returns = thenReturns && elseReturns;
+
+   m_res = new IfStatement{condition, thenStatement, elseStatement};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(ForStatement* forStatement)
+{
+   std::vector<VarDeclFragment*> initializers;
+   for (VarDeclFragment* vdf : forStatement->getInitializers())
+      initializers.push_back(fold(vdf));
+
+   // Nothing the loop changes is known in the condition or the body
+   std::vector<int> assigned;
+   addAssignedSlots(forStatement, assigned);
+   for (int slot : assigned) forget(slot);
+
+   ++m_loopDepth;
+   Expression* condition{fold(forStatement->getExpression())};
+   Value value;
+   if (literalValue(condition, value) && !value.asBool()) {
+      --m_loopDepth;
+      // The body never runs
+      delete condition;
+      for (VarDeclFragment* vdf : initializers)
+         delete vdf;
+      m_res = nullptr;
+      return;
+   }
+
+   Statement* body{fold(forStatement->getBody())};
+   if (!body) body = new Block;
+   std::vector<Expression*> updaters;
+   for (Expression* e : forStatement->getUpdaters())
+      updaters.push_back(fold(e));
+   --m_loopDepth;
+   for (int slot : assigned) forget(slot);
+   m_returns = false; // the body may not run at all
+
+   m_res = new ForStatement{initializers, condition, updaters, body};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(Name* name)
+{
+   int slot{name->getSlot()};
+   if (slot < static_cast<int>(m_known.size()) && m_known[slot].type != Type::VOID)
+      m_res = makeLiteral(m_known[slot]);
+   else m_res = new Name{name->getName()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(BooleanLiteral* booleanLiteral)
+{
+   m_res = new BooleanLiteral{booleanLiteral->booleanValue()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(NumberLiteral* numberLiteral)
+{
+   m_res = new NumberLiteral{numberLiteral->getValue()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(InfixExpression* infixExpression)
+{
+   Expression* left{fold(infixExpression->getLeftOperand())};
+   Expression* right{fold(infixExpression->getRightOperand())};
+   InfixOperator op{infixExpression->getOperator()};
+   Value l, r;
+   bool leftKnown{literalValue(left, l)};
+   bool rightKnown{literalValue(right, r)};
+
+   if (leftKnown && rightKnown) {
+      Value value;
+      switch (op) {
+         case InfixOperator::LESS_EQUALS:
+            value = Value::ofBool(l.asInt() <= r.asInt());
+            break;
+         case InfixOperator::EQUALS:
+            if (l.type != r.type) throw BadArgument{};
+            value = Value::ofBool(l.number == r.number);
+            break;
+         case InfixOperator::PLUS:
+            value = Value::ofInt(wrapAdd(l.asInt(), r.asInt()));
+            break;
+         case InfixOperator::TIMES:
+            value = Value::ofInt(wrapMultiply(l.asInt(), r.asInt()));
+            break;
+         default:
+            throw BadArgument{};
+      }
+      delete left;
+      delete right;
+      m_res = makeLiteral(value);
+      return;
+   }
+
+   // x + 0, x * 1 and x * 0, either way round. Expressions have no side effects
+   // other than ++ and --, which are only used as for-loop updaters.
+   if (leftKnown || rightKnown) {
+      Value known{leftKnown ? l : r};
+      Expression* other{leftKnown ? right : left};
+      Expression* literal{leftKnown ? left : right};
+      if ((op == InfixOperator::PLUS && known == Value::ofInt(0)) ||
+            (op == InfixOperator::TIMES && known == Value::ofInt(1))) {
+         delete literal;
+         m_res = other;
+         return;
+      }
+      if (op == InfixOperator::TIMES && known == Value::ofInt(0)) {
+         delete other;
+         m_res = literal;
+         return;
+      }
+   }
+   // In a loop, a variable is cheaper to read than a literal (a register rather
+   // than a LOAD_CONSTANT in BytecodeVM), so its name stays unless the whole
+   // expression folds
+   if (m_loopDepth > 0) {
+      if (Name* name = dynamic_cast<Name*>(infixExpression->getLeftOperand())) {
+         delete left;
+         left = new Name{name->getName()};
+      }
+      if (Name* name = dynamic_cast<Name*>(infixExpression->getRightOperand())) {
+         delete right;
+         right = new Name{name->getName()};
+      }
+   }
+   m_res = new InfixExpression{left, op, right};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(PostfixExpression* postfixExpression)
+{
+   Name* name{dynamic_cast<Name*>(postfixExpression->getLeftOperand())};
+   if (!name) throw BadArgument{};
+   int slot{name->getSlot()};
+   if (slot < static_cast<int>(m_known.size()) && m_known[slot].type == Type::INT) {
+      int step{postfixExpression->getOperator() == PostfixOperator::INCREMENT ?
+         1 : -1};
+      setKnown(slot, Value::ofInt(wrapAdd(m_known[slot].asInt(), step)));
+   }
+   m_res = new PostfixExpression{new Name{name->getName()},
+      postfixExpression->getOperator()};
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::visit(VarDeclFragment* varDeclFragment)
+{
+   Name* name{varDeclFragment->getLeftOperand()};
+   Expression* expression{fold(varDeclFragment->getRightOperand())};
+   Value value;
+   if (literalValue(expression, value)) setKnown(name->getSlot(), value);
+   else forget(name->getSlot());
+   m_res = new VarDeclFragment{new Name{name->getName()}, expression,
+      varDeclFragment->getType()};
+}
+
+//------------------------------------------------------------------------------------
+
+Expression* ConstantFolder::fold(Expression* expression)
+{
+   expression->accept(this);
+   return static_cast<Expression*>(m_res);
+}
+
+//------------------------------------------------------------------------------------
+
+Statement* ConstantFolder::fold(Statement* statement)
+{
+   statement->accept(this);
+   return static_cast<Statement*>(m_res);
+}
+
+//------------------------------------------------------------------------------------
+
+VarDeclFragment* ConstantFolder::fold(VarDeclFragment* varDeclFragment)
+{
+   varDeclFragment->accept(this);
+   return static_cast<VarDeclFragment*>(m_res);
+}
+
+//------------------------------------------------------------------------------------
+
+// Adds the folded statements of from to to, up to the first that must return
+void ConstantFolder::foldInto(Block* from, Block* to)
+{
+   Block* enclosing{m_block};
+   m_block = to;
+   for (Statement* s : from->getStatements()) {
+      if (m_returns) break;
+      Statement* folded{fold(s)};
+      if (folded) to->addStatement(folded);
+   }
+   m_block = enclosing;
+}
+
+//------------------------------------------------------------------------------------
+
+void ConstantFolder::setKnown(int slot, const Value& value)
+{
+   if (slot >= static_cast<int>(m_known.size())) m_known.resize(slot + 1);
+   m_known[slot] = value;
+}
@@ -0,0 +1,101 @@
+#include "AST.h"
+#include <climits>
+
+bool DecisionTable::build(Boilerplate* program)
+{
+   m_method = nullptr;
+   m_thresholds.clear();
+   m_strides.clear();
+   m_outcomes.clear();
+
+   if (program->getBodyDeclarations().size() != 1) return false;
+   m_method = 
+      dynamic_cast<MethodDeclaration*>(program->getBodyDeclarations().front());
+   if (!m_method) return false;
+   m_thresholds.resize(m_method->getParamList().size());
+   if (!addThresholds(m_method->getBody())) {
+      m_thresholds.clear();
+      return false;
+   }
+
+   // Cell k of a parameter holds the values in (thresholds[k-1], thresholds[k]],
+   // and the last cell everything above the largest threshold.
+   const unsigned MAX_CELLS{1 << 20};
+   unsigned numberCells{1};
+   for (std::vector<int>& t : m_thresholds) {
+      std::sort(t.begin(), t.end());
+      t.erase(std::unique(t.begin(), t.end()), t.end());
+      m_strides.push_back(numberCells);
+      numberCells *= t.size() + 1;
+      if (numberCells > MAX_CELLS) throw BadSize{};
+   }
+
+   // Fill the table by running the program once on a value from each cell:
+   // the cell's upper threshold, or one past the largest threshold.
+   BytecodeCompiler compiler;
+   program->accept(&compiler);
+   BytecodeVM vm;
+   std::vector<int> args(m_thresholds.size());
+   m_outcomes.resize(numberCells);
+   for (unsigned cell=0; cell<numberCells; ++cell) {
+      for (unsigned j=0; j<m_thresholds.size(); ++j) {
+         const std::vector<int>& t = m_thresholds.at(j);
+         unsigned k{cell / m_strides.at(j) % static_cast<unsigned>(t.size() + 1)};
+         if (k < t.size()) args.at(j) = t.at(k);
+         else if (t.empty()) args.at(j) = 0;
+         else if (t.back() == INT_MAX) args.at(j) = INT_MAX; // empty cell
+         else args.at(j) = t.back() + 1;
+      }
+      m_outcomes.at(cell) = vm.run(compiler.getBytecode(), args);
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+
+int DecisionTable::lookup(const int* args) const
+{
+   if (m_outcomes.empty()) throw BadArgument{};
+   unsigned cell{0};
+   for (unsigned j=0; j<m_thresholds.size(); ++j) {
+      unsigned k{0};
+      for (int t : m_thresholds[j]) k += args[j] > t;
+      cell += k * m_strides[j];
+   }
+   return m_outcomes[cell];
+}
+
+//------------------------------------------------------------------------------------
+
+// Records the literal of every "parameter <= literal" condition in statement,
+// and returns false if statement contains anything other than such if-else
+// statements, blocks and returns of number literals.
+bool DecisionTable::addThresholds(Statement* statement)
+{
+   if (Block* block = dynamic_cast<Block*>(statement)) {
+      // Only the first statement of a block runs, since it always returns
+      return !block->getStatements().empty() && 
+         addThresholds(block->getStatements().front());
+   }
+   if (ReturnStatement* returnStatement = dynamic_cast<ReturnStatement*>(statement))
+      return dynamic_cast<NumberLiteral*>(returnStatement->getExpression());
+
+   IfStatement* ifStatement{dynamic_cast<IfStatement*>(statement)};
+   if (!ifStatement || !ifStatement->getElseStatement()) return false;
+   InfixExpression* condition{
+      dynamic_cast<InfixExpression*>(ifStatement->getExpression())};
+   if (!condition || condition->getOperator() != InfixOperator::LESS_EQUALS) 
+      return false;
+   Name* name{dynamic_cast<Name*>(condition->getLeftOperand())};
+   NumberLiteral* number{dynamic_cast<NumberLiteral*>(condition->getRightOperand())};
+   if (!name || !number) return false;
+
+   const std::vector<Parameter>& params = m_method->getParamList();
+   unsigned j{0};
+   while (j < params.size() && params.at(j).name != name->getName()) ++j;
+   if (j == params.size()) return false;
+   m_thresholds.at(j).push_back(number->getValue());
+
+   return addThresholds(ifStatement->getThenStatement()) &&
+      addThresholds(ifStatement->getElseStatement());
+}
@@ -0,0 +1,494 @@
+#include "AST.h"
+
+int Value::asInt() const
+{
+   if (type != Type::INT) throw BadArgument{};
+   return number;
+}
+
+//------------------------------------------------------------------------------------
+
+bool Value::asBool() const
+{
+   if (type != Type::BOOL) throw BadArgument{};
+   return number != 0;
+}
+
+//------------------------------------------------------------------------------------
+
+// Integer overflow wraps around, as in BytecodeVM
+static int wrapAdd(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+static int wrapMultiply(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+Value EvaluationFrame::run(Boilerplate* program, const std::vector<int>& args)
+{
+   m_args = &args;
+   m_vars.assign(SymbolTable::global().size(), Value{});
+   m_declared.assign(SymbolTable::global().size(), false);
+   m_values.clear();
+   m_loops.clear();
+   m_returned = false;
+
+   walk(program);
+
+   // As with BytecodeVM, the method has to reach a return statement
+   if (!m_returned) throw BadArgument{};
+   return m_result;
+}
+
+//------------------------------------------------------------------------------------
+
+ASTNode* EvaluationFrame::nextChild(TesterBoilerplate* tester, int& child)
+{
+   throw BadArgument{}; // not a program
+}
+
+//------------------------------------------------------------------------------------
+
+ASTNode* EvaluationFrame::nextChild(MethodDeclaration* methodDeclaration, 
+      int& child)
+{
+   if (child != NO_CHILD) return nullptr;
+   const std::vector<Parameter>& params = methodDeclaration->getParamList();
+   if (params.size() != m_args->size()) throw BadSize{};
+   for (unsigned i=0; i<params.size(); ++i) {
+      // A parameter that no Name has been made for can't be used in the body
+      int slot{SymbolTable::global().find(params.at(i).name)};
+      if (slot != -1) declare(slot, Value::ofInt(m_args->at(i)));
+   }
+   child = 0;
+   return methodDeclaration->getBody();
+}
+
+//------------------------------------------------------------------------------------
+
+ASTNode* EvaluationFrame::nextChild(AssertStatement* assert, int& child)
+{
+   throw BadArgument{}; // not a program
+}
+
+//------------------------------------------------------------------------------------
+
+// Expressions that quick() works out aren't walked, here and below
+ASTNode* EvaluationFrame::nextChild(ReturnStatement* returnStatement, int& child)
+{
+   if (child != NO_CHILD) return nullptr;
+   child = 0;
+   Expression* expression{returnStatement->getExpression()};
+   return walks(expression) ? expression : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(ReturnStatement* returnStatement)
+{
+   m_result = pop();
+   m_returned = true;
+   stop();
+}
+
+//------------------------------------------------------------------------------------
+
+// Only the expression is walked, not the name assigned to
+ASTNode* EvaluationFrame::nextChild(AssignmentStatement* assignmentStatement, 
+      int& child)
+{
+   if (child != NO_CHILD) return nullptr;
+   // The variable has to be declared before its new value is worked out
+   variable(assignmentStatement->getName()->getSlot());
+   child = 1;
+   Expression* expression{assignmentStatement->getExpression()};
+   return walks(expression) ? expression : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(AssignmentStatement* assignmentStatement)
+{
+   Value value{pop()};
+   Value& assignTo = variable(assignmentStatement->getName()->getSlot());
+   if (value.type != assignTo.type) throw BadArgument{};
+   assignTo = value;
+}
+
+//------------------------------------------------------------------------------------
+
+ASTNode* EvaluationFrame::nextChild(IfStatement* ifStatement, int& child)
+{
+   Value condition;
+   if (child == NO_CHILD) {
+      child = 0;
+      if (!quick(ifStatement->getExpression(), condition)) 
+         return ifStatement->getExpression();
+   }
+   else if (child == 0) condition = pop();
+   else return nullptr;
+   if (condition.asBool()) {
+      child = 1;
+      return ifStatement->getThenStatement();
+   }
+   child = 2;
+   return ifStatement->getElseStatement(); // if any
+}
+
+//------------------------------------------------------------------------------------
+
+// The initializers, then the condition until it is false, with the body (or its
+// step) and the updaters after each time it is true
+ASTNode* EvaluationFrame::nextChild(ForStatement* forStatement, int& child)
+{
+   const std::vector<VarDeclFragment*>& inits = forStatement->getInitializers();
+   const std::vector<Expression*>& updaters = forStatement->getUpdaters();
+   const int numberInits = inits.size();
+   const int condition{numberInits};
+   const int body{numberInits + static_cast<int>(updaters.size()) + 1};
+
+   Value value; // of the condition or updater child
+   if (child == NO_CHILD) m_loops.emplace_back();
+   Loop& loop = m_loops.back();
+   if (child < numberInits - 1) return inits[++child];
+   if (child == numberInits - 1) {
+      // A body that only assigns ints is run as an ExpressionDag, which works
+      // out each distinct subexpression once per iteration
+      loop.straightLine = buildStep(forStatement->getBody(), loop.step, 
+            loop.assigned);
+      loop.nodeValues.resize(loop.step.size());
+      for (int slot : loop.assigned) 
+         loop.newValues.push_back(loop.step.valueOf(slot));
+      child = condition;
+      if (!quick(forStatement->getExpression(), value)) 
+         return forStatement->getExpression();
+   }
+   else if (child != body) value = pop();
+   for (;;) {
+      if (child == condition) {
+         if (!value.asBool()) return nullptr;
+         if (!loop.straightLine) {
+            child = body;
+            return forStatement->getBody();
+         }
+         runStep(loop);
+         child = body;
+      }
+      // Next, the updater after child or, after the last, the condition again
+      if (child == body) child = condition;
+      Expression* next;
+      if (++child < body) next = updaters[child - condition - 1];
+      else {
+         child = condition;
+         next = forStatement->getExpression();
+      }
+      if (!quick(next, value)) return next;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(ForStatement* forStatement)
+{
+   m_loops.pop_back();
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(Name* name)
+{
+   m_values.push_back(variable(name->getSlot()));
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(BooleanLiteral* booleanLiteral)
+{
+   m_values.push_back(Value::ofBool(booleanLiteral->booleanValue()));
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(NumberLiteral* numberLiteral)
+{
+   m_values.push_back(Value::ofInt(numberLiteral->getValue()));
+}
+
+//------------------------------------------------------------------------------------
+
+// Names and literals are read by leave() rather than pushed
+ASTNode* EvaluationFrame::nextChild(InfixExpression* infixExpression, int& child)
+{
+   Expression* left{infixExpression->getLeftOperand()};
+   Expression* right{infixExpression->getRightOperand()};
+   if (child == NO_CHILD) {
+      child = 0;
+      if (!isLeaf(left) && walks(left)) return left;
+   }
+   if (child == 0) {
+      child = 1;
+      if (!isLeaf(right) && walks(right)) return right;
+   }
+   return nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(InfixExpression* infixExpression)
+{
+   m_values.push_back(apply(infixExpression));
+}
+
+//------------------------------------------------------------------------------------
+
+// The operand is a variable, changed by leave()
+ASTNode* EvaluationFrame::nextChild(PostfixExpression* postfixExpression, 
+      int& child)
+{
+   return nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(PostfixExpression* postfixExpression)
+{
+   m_values.push_back(apply(postfixExpression));
+}
+
+//------------------------------------------------------------------------------------
+
+ASTNode* EvaluationFrame::nextChild(VarDeclFragment* varDeclFragment, int& child)
+{
+   if (child != NO_CHILD) return nullptr;
+   child = 1;
+   Expression* expression{varDeclFragment->getRightOperand()};
+   return walks(expression) ? expression : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::leave(VarDeclFragment* varDeclFragment)
+{
+   Value value{pop()};
+   if (value.type != varDeclFragment->getType()) throw BadArgument{};
+   declare(varDeclFragment->getLeftOperand()->getSlot(), value);
+}
+
+//------------------------------------------------------------------------------------
+
+// Returns false if expression has to be walked. Otherwise, its value is quick to
+// work out, and is put in value: names, literals, postfix expressions and infix
+// expressions of names and literals, which most expressions are.
+bool EvaluationFrame::quick(Expression* expression, Value& value)
+{
+   switch (expression->getKind()) {
+      case NodeKind::NAME:
+      case NodeKind::BOOLEAN_LITERAL:
+      case NodeKind::NUMBER_LITERAL:
+         value = operand(expression);
+         return true;
+      case NodeKind::INFIX_EXPRESSION: {
+         InfixExpression* infix{static_cast<InfixExpression*>(expression)};
+         if (!isLeaf(infix->getLeftOperand()) || !isLeaf(infix->getRightOperand()))
+            return false;
+         value = apply(infix);
+         return true;
+      }
+      case NodeKind::POSTFIX_EXPRESSION:
+         value = apply(static_cast<PostfixExpression*>(expression));
+         return true;
+      default:
+         return false;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+// As quick(), but pushes the value
+bool EvaluationFrame::walks(Expression* expression)
+{
+   Value value;
+   if (!quick(expression, value)) return true;
+   m_values.push_back(value);
+   return false;
+}
+
+//------------------------------------------------------------------------------------
+
+// Operands that aren't names or literals have had their values pushed, and are
+// popped in the opposite order
+Value EvaluationFrame::apply(InfixExpression* infix)
+{
+   Value right{operand(infix->getRightOperand())};
+   Value left{operand(infix->getLeftOperand())};
+   switch (infix->getOperator()) {
+      case InfixOperator::LESS_EQUALS:
+         return Value::ofBool(left.asInt() <= right.asInt());
+      case InfixOperator::EQUALS:
+         // Either two ints or two bools
+         if (left.type != right.type) throw BadArgument{};
+         return Value::ofBool(left.number == right.number);
+      case InfixOperator::PLUS:
+         return Value::ofInt(wrapAdd(left.asInt(), right.asInt()));
+      case InfixOperator::TIMES:
+         return Value::ofInt(wrapMultiply(left.asInt(), right.asInt()));
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+Value EvaluationFrame::apply(PostfixExpression* postfix)
+{
+   // Only variable++ or variable-- is supported
+   if (postfix->getLeftOperand()->getKind() != NodeKind::NAME) throw BadArgument{};
+   Value& operand = variable(
+         static_cast<Name*>(postfix->getLeftOperand())->getSlot());
+   switch (postfix->getOperator()) {
+      case PostfixOperator::INCREMENT:
+         operand = Value::ofInt(wrapAdd(operand.asInt(), 1));
+         break;
+      case PostfixOperator::DECREMENT:
+         operand = Value::ofInt(wrapAdd(operand.asInt(), -1));
+         break;
+      default:
+         throw BadArgument{};
+   }
+   return operand;
+}
+
+//------------------------------------------------------------------------------------
+
+// Runs one iteration of a straight-line loop body
+void EvaluationFrame::runStep(Loop& loop)
+{
+   for (int id=0; id<loop.step.size(); ++id) {
+      const ExpressionDag::Node& node = loop.step.getNode(id);
+      switch (node.kind) {
+         case ExpressionDag::Kind::VARIABLE:
+            loop.nodeValues[id] = variable(node.value).number;
+            break;
+         case ExpressionDag::Kind::CONSTANT:
+            loop.nodeValues[id] = node.value;
+            break;
+         case ExpressionDag::Kind::INFIX:
+            loop.nodeValues[id] = node.op == InfixOperator::PLUS ?
+               wrapAdd(loop.nodeValues[node.left], loop.nodeValues[node.right]) :
+               wrapMultiply(loop.nodeValues[node.left], loop.nodeValues[node.right]);
+            break;
+      }
+   }
+   for (unsigned i=0; i<loop.assigned.size(); ++i)
+      variable(loop.assigned[i]).number = loop.nodeValues[loop.newValues[i]];
+}
+
+//------------------------------------------------------------------------------------
+
+// Returns false, unless body is a block of assignments of int expressions to
+// int variables, in which case step is made from it and assigned gets the slots
+// of the variables assigned
+bool EvaluationFrame::buildStep(Statement* body, ExpressionDag& step,
+      std::vector<int>& assigned)
+{
+   Block* block{dynamic_cast<Block*>(body)};
+   if (!block) return false;
+   try {
+      for (Statement* s : block->getStatements()) {
+         AssignmentStatement* assignment{dynamic_cast<AssignmentStatement*>(s)};
+         if (!assignment) return false;
+         int slot{assignment->getName()->getSlot()};
+         step.assign(slot, assignment->getExpression());
+         if (std::find(assigned.begin(), assigned.end(), slot) == assigned.end())
+            assigned.push_back(slot);
+      }
+   }
+   catch (BadArgument) {
+      return false; // not just + and *
+   }
+   // Anything else is left to the tree walk to report, if the loop runs
+   auto isInt = [this](int slot) {
+      return slot < static_cast<int>(m_declared.size()) && m_declared[slot] &&
+         m_vars[slot].type == Type::INT;
+   };
+   for (int slot : assigned)
+      if (!isInt(slot)) return false;
+   for (int id=0; id<step.size(); ++id) {
+      const ExpressionDag::Node& node = step.getNode(id);
+      if (node.kind == ExpressionDag::Kind::VARIABLE && !isInt(node.value))
+         return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+
+Value EvaluationFrame::pop()
+{
+   Value value{m_values.back()};
+   m_values.pop_back();
+   return value;
+}
+
+//------------------------------------------------------------------------------------
+
+bool EvaluationFrame::isLeaf(Expression* expression)
+{
+   NodeKind kind{expression->getKind()};
+   return kind >= NodeKind::NAME && kind <= NodeKind::NUMBER_LITERAL;
+}
+
+//------------------------------------------------------------------------------------
+
+// The value of a name or literal, or else the one pushed for expression
+Value EvaluationFrame::operand(Expression* expression)
+{
+   switch (expression->getKind()) {
+      case NodeKind::NAME:
+         return variable(static_cast<Name*>(expression)->getSlot());
+      case NodeKind::BOOLEAN_LITERAL:
+         return Value::ofBool(
+               static_cast<BooleanLiteral*>(expression)->booleanValue());
+      case NodeKind::NUMBER_LITERAL:
+         return Value::ofInt(static_cast<NumberLiteral*>(expression)->getValue());
+      default:
+         return pop();
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+Value& EvaluationFrame::variable(int slot)
+{
+   if (slot >= static_cast<int>(m_declared.size()) || !m_declared[slot])
+      throw BadArgument{};
+   return m_vars[slot];
+}
+
+//------------------------------------------------------------------------------------
+
+void EvaluationFrame::declare(int slot, const Value& value)
+{
+   if (slot >= static_cast<int>(m_declared.size())) {
+      m_vars.resize(slot + 1);
+      m_declared.resize(slot + 1);
+   }
+   if (m_declared[slot]) throw BadArgument{};
+   m_declared[slot] = true;
+   m_vars[slot] = value;
+}
+
+//------------------------------------------------------------------------------------
+
+Value evaluate(Boilerplate* program, const std::vector<int>& args)
+{
+   EvaluationFrame frame;
+   return frame.run(program, args);
+}
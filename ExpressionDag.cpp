@@ -0,0 +1,66 @@
+#include "AST.h"
+
+int ExpressionDag::add(Expression* expression)
+{
+   if (Name* name = dynamic_cast<Name*>(expression))
+      return valueOf(name->getSlot());
+   if (NumberLiteral* number = dynamic_cast<NumberLiteral*>(expression))
+      return addNode(Node{Kind::CONSTANT, number->getValue(),
+            InfixOperator::PLUS, -1, -1});
+
+   InfixExpression* infix{dynamic_cast<InfixExpression*>(expression)};
+   if (!infix || (infix->getOperator() != InfixOperator::PLUS &&
+            infix->getOperator() != InfixOperator::TIMES))
+      throw BadArgument{};
+   int left{add(infix->getLeftOperand())};
+   int right{add(infix->getRightOperand())};
+   return addNode(Node{Kind::INFIX, 0, infix->getOperator(), left, right});
+}
+
+//------------------------------------------------------------------------------------
+
+void ExpressionDag::assign(int slot, Expression* expression)
+{
+   int value{add(expression)};
+   if (slot >= static_cast<int>(m_values.size())) m_values.resize(slot + 1, -1);
+   m_values[slot] = value;
+}
+
+//------------------------------------------------------------------------------------
+
+int ExpressionDag::valueOf(int slot)
+{
+   if (slot < static_cast<int>(m_values.size()) && m_values[slot] != -1)
+      return m_values[slot];
+   // Not assigned yet, so it's the variable's value from before
+   return addNode(Node{Kind::VARIABLE, slot, InfixOperator::PLUS, -1, -1});
+}
+
+//------------------------------------------------------------------------------------
+
+void ExpressionDag::countUses(const std::vector<int>& roots,
+      std::vector<unsigned>& uses) const
+{
+   uses.assign(m_nodes.size(), 0);
+   std::vector<int> stack(roots.rbegin(), roots.rend());
+   while (!stack.empty()) {
+      int id{stack.back()};
+      stack.pop_back();
+      if (uses.at(id)++ > 0 || m_nodes.at(id).kind != Kind::INFIX) continue;
+      stack.push_back(m_nodes.at(id).right);
+      stack.push_back(m_nodes.at(id).left);
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+int ExpressionDag::addNode(const Node& node)
+{
+   std::vector<int> key{static_cast<int>(node.kind), node.value,
+      static_cast<int>(node.op), node.left, node.right};
+   auto found = m_ids.find(key);
+   if (found != m_ids.end()) return found->second;
+   m_nodes.push_back(node);
+   m_ids.emplace(key, m_nodes.size() - 1);
+   return m_nodes.size() - 1;
+}
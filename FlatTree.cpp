@@ -0,0 +1,524 @@
+#include "AST.h"
+
+// Integer overflow wraps around, as in BytecodeVM
+static int wrapAdd(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+static int wrapMultiply(int a, int b)
+{
+   return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+//------------------------------------------------------------------------------------
+
+// Tree is a FlatTree or a MappedProgram, here and below
+template <typename Tree>
+static std::vector<std::uint32_t> childrenOf(const Tree& tree, std::uint32_t node)
+{
+   std::vector<std::uint32_t> children;
+   for (std::uint32_t child=node+1; child<tree.getEnd(node); child=tree.getEnd(child))
+      children.push_back(child);
+   return children;
+}
+
+//------------------------------------------------------------------------------------
+
+// Appends each node it visits to a FlatTree, followed by the node's children
+struct FlatTreeBuilder : ASTVisitor {
+   explicit FlatTreeBuilder(FlatTree& tree) :m_tree(tree) {}
+
+   void visit(TesterBoilerplate* tester) { throw BadArgument{}; }
+   void visit(Boilerplate* boilerplate);
+   void visit(MethodDeclaration* methodDeclaration);
+   void visit(VarDeclStatement* varDeclStatement);
+   void visit(AssertStatement* assert) { throw BadArgument{}; }
+   void visit(Block* block);
+   void visit(ReturnStatement* returnStatement);
+   void visit(AssignmentStatement* assignmentStatement);
+   void visit(IfStatement* ifStatement);
+   void visit(ForStatement* forStatement);
+   void visit(Name* name);
+   void visit(BooleanLiteral* booleanLiteral);
+   void visit(NumberLiteral* numberLiteral);
+   void visit(InfixExpression* infixExpression);
+   void visit(PostfixExpression* postfixExpression);
+   void visit(VarDeclFragment* varDeclFragment);
+private:
+   // Adds a node, whose subtree is ended by close(), and returns it
+   std::uint32_t open(NodeKind kind, int value);
+   void close(std::uint32_t node) { m_tree.m_ends.at(node) = m_tree.size(); }
+
+   FlatTree& m_tree;
+};
+
+//------------------------------------------------------------------------------------
+
+std::uint32_t FlatTreeBuilder::open(NodeKind kind, int value)
+{
+   m_tree.m_kinds.push_back(kind);
+   m_tree.m_values.push_back(value);
+   m_tree.m_ends.push_back(m_tree.size());
+   return m_tree.size() - 1;
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(Boilerplate* boilerplate)
+{
+   std::uint32_t node{open(NodeKind::BOILERPLATE, m_tree.m_names.size())};
+   m_tree.m_names.push_back(boilerplate->getNames());
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      d->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(MethodDeclaration* methodDeclaration)
+{
+   std::uint32_t node{open(NodeKind::METHOD_DECLARATION, m_tree.m_methods.size())};
+   m_tree.m_methods.push_back(FlatTree::Method{methodDeclaration->getName(),
+         methodDeclaration->getParamList(), methodDeclaration->getReturnType()});
+   methodDeclaration->getBody()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(VarDeclStatement* varDeclStatement)
+{
+   std::uint32_t node{open(NodeKind::VAR_DECL_STATEMENT,
+         static_cast<int>(varDeclStatement->getType()))};
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      vdf->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(Block* block)
+{
+   std::uint32_t node{open(NodeKind::BLOCK, 0)};
+   for (Statement* s : block->getStatements())
+      s->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(ReturnStatement* returnStatement)
+{
+   std::uint32_t node{open(NodeKind::RETURN_STATEMENT, 0)};
+   returnStatement->getExpression()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(AssignmentStatement* assignmentStatement)
+{
+   std::uint32_t node{open(NodeKind::ASSIGNMENT_STATEMENT, 0)};
+   assignmentStatement->getName()->accept(this);
+   assignmentStatement->getExpression()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(IfStatement* ifStatement)
+{
+   std::uint32_t node{open(NodeKind::IF_STATEMENT,
+         ifStatement->getElseStatement() ? 1 : 0)};
+   ifStatement->getExpression()->accept(this);
+   ifStatement->getThenStatement()->accept(this);
+   if (ifStatement->getElseStatement())
+      ifStatement->getElseStatement()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(ForStatement* forStatement)
+{
+   std::uint32_t node{open(NodeKind::FOR_STATEMENT,
+         forStatement->getInitializers().size())};
+   for (VarDeclFragment* vdf : forStatement->getInitializers())
+      vdf->accept(this);
+   forStatement->getExpression()->accept(this);
+   for (Expression* e : forStatement->getUpdaters())
+      e->accept(this);
+   forStatement->getBody()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(Name* name)
+{
+   close(open(NodeKind::NAME, name->getSlot()));
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(BooleanLiteral* booleanLiteral)
+{
+   close(open(NodeKind::BOOLEAN_LITERAL, booleanLiteral->booleanValue() ? 1 : 0));
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(NumberLiteral* numberLiteral)
+{
+   close(open(NodeKind::NUMBER_LITERAL, numberLiteral->getValue()));
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(InfixExpression* infixExpression)
+{
+   std::uint32_t node{open(NodeKind::INFIX_EXPRESSION,
+         static_cast<int>(infixExpression->getOperator()))};
+   infixExpression->getLeftOperand()->accept(this);
+   infixExpression->getRightOperand()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(PostfixExpression* postfixExpression)
+{
+   std::uint32_t node{open(NodeKind::POSTFIX_EXPRESSION,
+         static_cast<int>(postfixExpression->getOperator()))};
+   postfixExpression->getLeftOperand()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+void FlatTreeBuilder::visit(VarDeclFragment* varDeclFragment)
+{
+   std::uint32_t node{open(NodeKind::VAR_DECL_FRAGMENT,
+         static_cast<int>(varDeclFragment->getType()))};
+   varDeclFragment->getLeftOperand()->accept(this);
+   varDeclFragment->getRightOperand()->accept(this);
+   close(node);
+}
+
+//------------------------------------------------------------------------------------
+
+FlatTree::FlatTree(Boilerplate* program)
+{
+   FlatTreeBuilder builder{*this};
+   program->accept(&builder);
+}
+
+//------------------------------------------------------------------------------------
+
+unsigned FlatTree::numberChildren(std::uint32_t node) const
+{
+   unsigned count{0};
+   for (std::uint32_t child=node+1; child<getEnd(node); child=getEnd(child))
+      ++count;
+   return count;
+}
+
+//------------------------------------------------------------------------------------
+
+int FlatTree::getParamSlot(int method, unsigned i) const
+{
+   return SymbolTable::global().find(getMethod(method).params.at(i).name);
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> 
+static ASTNode* unflatten(const Tree& tree, std::uint32_t node);
+
+// Throws BadArgument if the node isn't a T
+template <typename T, typename Tree> 
+static T* unflattenAs(const Tree& tree, std::uint32_t node)
+{
+   ASTNode* astNode{unflatten(tree, node)};
+   T* t{dynamic_cast<T*>(astNode)};
+   if (!t) {
+      delete astNode;
+      throw BadArgument{};
+   }
+   return t;
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> 
+static ASTNode* unflatten(const Tree& tree, std::uint32_t node)
+{
+   std::vector<std::uint32_t> children{childrenOf(tree, node)};
+   int value{tree.getValue(node)};
+   switch (tree.getKind(node)) {
+      case NodeKind::BOILERPLATE: {
+         Boilerplate* boilerplate{new Boilerplate{tree.getNames(value)}};
+         for (std::uint32_t child : children)
+            boilerplate->addDeclaration(unflattenAs<Declaration>(tree, child));
+         return boilerplate;
+      }
+      case NodeKind::METHOD_DECLARATION: {
+         // A MappedProgram makes the Method, so it's bound to a reference
+         const FlatTree::Method& method = tree.getMethod(value);
+         return new MethodDeclaration{unflattenAs<Block>(tree, children.at(0)),
+            method.name, method.params, method.returnType};
+      }
+      case NodeKind::VAR_DECL_STATEMENT: {
+         std::vector<VarDeclFragment*> fragments;
+         for (std::uint32_t child : children)
+            fragments.push_back(unflattenAs<VarDeclFragment>(tree, child));
+         return new VarDeclStatement{fragments, static_cast<Type>(value)};
+      }
+      case NodeKind::BLOCK: {
+         Block* block{new Block};
+         for (std::uint32_t child : children)
+            block->addStatement(unflattenAs<Statement>(tree, child));
+         return block;
+      }
+      case NodeKind::RETURN_STATEMENT:
+         return new ReturnStatement{unflattenAs<Expression>(tree, children.at(0))};
+      case NodeKind::ASSIGNMENT_STATEMENT:
+         return new AssignmentStatement{unflattenAs<Name>(tree, children.at(0)),
+            unflattenAs<Expression>(tree, children.at(1))};
+      case NodeKind::IF_STATEMENT:
+         return new IfStatement{unflattenAs<Expression>(tree, children.at(0)),
+            unflattenAs<Statement>(tree, children.at(1)),
+            value ? unflattenAs<Statement>(tree, children.at(2)) : nullptr};
+      case NodeKind::FOR_STATEMENT: {
+         // initializers, condition, updaters, body
+         unsigned numberInits{static_cast<unsigned>(value)};
+         if (children.size() < numberInits + 2) throw BadSize{};
+         std::vector<VarDeclFragment*> inits;
+         for (unsigned i=0; i<numberInits; ++i)
+            inits.push_back(unflattenAs<VarDeclFragment>(tree, children.at(i)));
+         Expression* condition{unflattenAs<Expression>(tree, children.at(numberInits))};
+         std::vector<Expression*> updaters;
+         for (unsigned i=numberInits+1; i<children.size()-1; ++i)
+            updaters.push_back(unflattenAs<Expression>(tree, children.at(i)));
+         return new ForStatement{inits, condition, updaters,
+            unflattenAs<Statement>(tree, children.back())};
+      }
+      case NodeKind::NAME:
+         return new Name{SymbolTable::global().getIdentifier(value)};
+      case NodeKind::BOOLEAN_LITERAL:
+         return new BooleanLiteral{value != 0};
+      case NodeKind::NUMBER_LITERAL:
+         return new NumberLiteral{value};
+      case NodeKind::INFIX_EXPRESSION:
+         return new InfixExpression{unflattenAs<Expression>(tree, children.at(0)),
+            static_cast<InfixOperator>(value),
+            unflattenAs<Expression>(tree, children.at(1))};
+      case NodeKind::POSTFIX_EXPRESSION:
+         return new PostfixExpression{unflattenAs<Expression>(tree, children.at(0)),
+            static_cast<PostfixOperator>(value)};
+      case NodeKind::VAR_DECL_FRAGMENT:
+         return new VarDeclFragment{unflattenAs<Name>(tree, children.at(0)),
+            unflattenAs<Expression>(tree, children.at(1)), static_cast<Type>(value)};
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+Boilerplate* FlatTree::toAST() const
+{
+   if (size() == 0) throw BadSize{};
+   return unflattenAs<Boilerplate>(*this, 0);
+}
+
+//------------------------------------------------------------------------------------
+
+Boilerplate* MappedProgram::toAST() const
+{
+   if (size() == 0) throw BadSize{};
+   return unflattenAs<Boilerplate>(*this, 0);
+}
+
+//------------------------------------------------------------------------------------
+
+// The state of one run of a flattened program. As in EvaluationFrame, variables
+// are held by symbol table slot and the first return statement reached ends it.
+template <typename Tree> struct FlatEvaluator {
+   FlatEvaluator(const Tree& tree, const std::vector<int>& args)
+      :m_tree(tree), m_args(args) {}
+
+   // Returns true once a return statement has been run
+   bool execute(std::uint32_t node);
+   Value evaluate(std::uint32_t node);
+
+   Value m_result;
+private:
+   Value& variable(int slot);
+   void declare(int slot, const Value& value);
+
+   const Tree& m_tree;
+   const std::vector<int>& m_args;
+   std::vector<Value> m_vars;
+   std::vector<bool> m_declared;
+};
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> bool FlatEvaluator<Tree>::execute(std::uint32_t node)
+{
+   switch (m_tree.getKind(node)) {
+      case NodeKind::BOILERPLATE:
+      case NodeKind::BLOCK:
+         for (std::uint32_t child=node+1; child<m_tree.getEnd(node);
+               child=m_tree.getEnd(child))
+            if (execute(child)) return true;
+         return false;
+      case NodeKind::METHOD_DECLARATION: {
+         int method{m_tree.getValue(node)};
+         if (m_tree.numberParams(method) != m_args.size()) throw BadSize{};
+         for (unsigned i=0; i<m_args.size(); ++i) {
+            int slot{m_tree.getParamSlot(method, i)};
+            if (slot != -1) declare(slot, Value::ofInt(m_args.at(i)));
+         }
+         return execute(node + 1);
+      }
+      case NodeKind::VAR_DECL_STATEMENT:
+         for (std::uint32_t child=node+1; child<m_tree.getEnd(node);
+               child=m_tree.getEnd(child))
+            evaluate(child);
+         return false;
+      case NodeKind::RETURN_STATEMENT:
+         m_result = evaluate(node + 1);
+         return true;
+      case NodeKind::ASSIGNMENT_STATEMENT: {
+         Value value{evaluate(m_tree.getEnd(node + 1))};
+         Value& assignTo = variable(m_tree.getValue(node + 1));
+         if (value.type != assignTo.type) throw BadArgument{};
+         assignTo = value;
+         return false;
+      }
+      case NodeKind::IF_STATEMENT: {
+         std::uint32_t thenStatement{m_tree.getEnd(node + 1)};
+         if (evaluate(node + 1).asBool()) return execute(thenStatement);
+         if (m_tree.getValue(node)) return execute(m_tree.getEnd(thenStatement));
+         return false;
+      }
+      case NodeKind::FOR_STATEMENT: {
+         std::vector<std::uint32_t> children{childrenOf(m_tree, node)};
+         unsigned numberInits{static_cast<unsigned>(m_tree.getValue(node))};
+         for (unsigned i=0; i<numberInits; ++i)
+            evaluate(children.at(i));
+         while (evaluate(children.at(numberInits)).asBool()) {
+            if (execute(children.back())) return true;
+            for (unsigned i=numberInits+1; i<children.size()-1; ++i)
+               evaluate(children.at(i));
+         }
+         return false;
+      }
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> Value FlatEvaluator<Tree>::evaluate(std::uint32_t node)
+{
+   int value{m_tree.getValue(node)};
+   switch (m_tree.getKind(node)) {
+      case NodeKind::NAME:
+         return variable(value);
+      case NodeKind::BOOLEAN_LITERAL:
+         return Value::ofBool(value != 0);
+      case NodeKind::NUMBER_LITERAL:
+         return Value::ofInt(value);
+      case NodeKind::INFIX_EXPRESSION: {
+         Value left{evaluate(node + 1)};
+         Value right{evaluate(m_tree.getEnd(node + 1))};
+         switch (static_cast<InfixOperator>(value)) {
+            case InfixOperator::LESS_EQUALS:
+               return Value::ofBool(left.asInt() <= right.asInt());
+            case InfixOperator::EQUALS:
+               if (left.type != right.type) throw BadArgument{};
+               return Value::ofBool(left.number == right.number);
+            case InfixOperator::PLUS:
+               return Value::ofInt(wrapAdd(left.asInt(), right.asInt()));
+            case InfixOperator::TIMES:
+               return Value::ofInt(wrapMultiply(left.asInt(), right.asInt()));
+            default:
+               throw BadArgument{};
+         }
+      }
+      case NodeKind::POSTFIX_EXPRESSION: {
+         // Only variable++ or variable-- is supported
+         if (m_tree.getKind(node + 1) != NodeKind::NAME) throw BadArgument{};
+         Value& operand = variable(m_tree.getValue(node + 1));
+         int step{static_cast<PostfixOperator>(value) == PostfixOperator::INCREMENT ?
+            1 : -1};
+         operand = Value::ofInt(wrapAdd(operand.asInt(), step));
+         return operand;
+      }
+      case NodeKind::VAR_DECL_FRAGMENT: {
+         Value initial{evaluate(m_tree.getEnd(node + 1))};
+         if (initial.type != static_cast<Type>(value)) throw BadArgument{};
+         declare(m_tree.getValue(node + 1), initial);
+         return initial;
+      }
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> Value& FlatEvaluator<Tree>::variable(int slot)
+{
+   if (slot >= static_cast<int>(m_declared.size()) || !m_declared[slot])
+      throw BadArgument{};
+   return m_vars[slot];
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> 
+void FlatEvaluator<Tree>::declare(int slot, const Value& value)
+{
+   if (slot >= static_cast<int>(m_declared.size())) {
+      m_vars.resize(slot + 1);
+      m_declared.resize(slot + 1);
+   }
+   if (m_declared[slot]) throw BadArgument{};
+   m_declared[slot] = true;
+   m_vars[slot] = value;
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Tree> 
+static Value evaluateFlat(const Tree& program, const std::vector<int>& args)
+{
+   if (program.size() == 0 || program.getKind(0) != NodeKind::BOILERPLATE)
+      throw BadArgument{};
+   FlatEvaluator<Tree> evaluator{program, args};
+   // As with BytecodeVM, the method has to reach a return statement
+   if (!evaluator.execute(0)) throw BadArgument{};
+   return evaluator.m_result;
+}
+
+//------------------------------------------------------------------------------------
+
+Value evaluate(const FlatTree& program, const std::vector<int>& args)
+{
+   return evaluateFlat(program, args);
+}
+
+//------------------------------------------------------------------------------------
+
+Value evaluate(const MappedProgram& program, const std::vector<int>& args)
+{
+   return evaluateFlat(program, args);
+}
@@ -2,27 +2,28 @@
 
 void HaskellPrinter::visit(TesterBoilerplate* tester)
 {
-   *m_os << "import Test.HUnit" << std::endl;
+   *m_out << "import Test.HUnit" << '\n';
    // oops, capitalized package names
-   *m_os << "import " << "Se2s03." << tester->getClassName()
-     << std::endl;
+   *m_out << "import " << "Se2s03." << tester->getClassName()
+     << '\n';
 
    setIndents(0);
    for (unsigned i=0; i<tester->getAsserts().size(); ++i) {
       printIndents();
-      *m_os << "test" << i+1 << " = TestCase ("; 
-      tester->getAsserts().at(i)->accept(this);
-      *m_os << ')' << std::endl;
+      *m_out << "test" << i+1 << " = TestCase ("; 
+      AssertStatement as{tester->getAsserts(), i};
+      as.accept(this);
+      *m_out << ')' << '\n';
    }
 
-   *m_os << std::endl;
-   *m_os << "tests = TestList [";
+   *m_out << '\n';
+   *m_out << "tests = TestList [";
    for (int i=0; i< (int) tester->getAsserts().size(); ++i) {
       if (i < (int) tester->getAsserts().size() - 1)
-         *m_os << "TestLabel \"test" << i+1 << "\" test" << i+1 << ',' << std::endl
+         *m_out << "TestLabel \"test" << i+1 << "\" test" << i+1 << ',' << '\n'
             << "                  ";
       else
-         *m_os << "TestLabel \"test" << i+1 << "\" test" << i+1 << ']';
+         *m_out << "TestLabel \"test" << i+1 << "\" test" << i+1 << ']';
    }
 }
 
@@ -31,8 +32,8 @@ void HaskellPrinter::visit(TesterBoilerplate* tester)
 void HaskellPrinter::visit(Boilerplate* boilerplate)
 {
    setIndents(0);
-   *m_os << "module " << boilerplate->getName(0) << '.' 
-      << boilerplate->getName(1) << std::endl;
+   *m_out << "module " << boilerplate->getName(0) << '.' 
+      << boilerplate->getName(1) << '\n';
    for (Declaration* d : boilerplate->getBodyDeclarations())
       d->accept(this);
 }
@@ -41,18 +42,19 @@ void HaskellPrinter::visit(Boilerplate* boilerplate)
 
 void HaskellPrinter::visit(MethodDeclaration* methodDeclaration)
 {
-   *m_os << '(' << methodDeclaration->getName() << ") where\n\n"
+   m_variables.clear();
+   *m_out << '(' << methodDeclaration->getName() << ") where\n\n"
       << methodDeclaration->getName() << " :: (Integral a) => ";
    if (methodDeclaration->getParamList().size() > 0) {
       for (unsigned i=0; i<methodDeclaration->getParamList().size(); ++i)
-         *m_os << "a -> ";
-      *m_os << 'a' << std::endl << methodDeclaration->getName() << ' ';
+         *m_out << "a -> ";
+      *m_out << 'a' << '\n' << methodDeclaration->getName() << ' ';
       for (unsigned i=0; i<methodDeclaration->getParamList().size()-1; ++i) {
          const Parameter& p = methodDeclaration->getParamList().at(i);
-         *m_os << p.name << ' ';
+         *m_out << p.name << ' ';
       }
       const Parameter& p = methodDeclaration->getParamList().back();
-      *m_os << p.name << " = do" << std::endl;
+      *m_out << p.name << " = do" << '\n';
    }
    incrementIndents();
    printIndents();
@@ -64,13 +66,13 @@ void HaskellPrinter::visit(MethodDeclaration* methodDeclaration)
 
 void HaskellPrinter::visit(VarDeclStatement* varDeclStatement)
 {
-   *m_os << "let ";
+   *m_out << "let ";
    for (unsigned i=0; i<varDeclStatement->getFragments().size(); ++i) {
       varDeclStatement->getFragments().at(i)->accept(this);
       if (i != varDeclStatement->getFragments().size() - 1)
-         *m_os << "; ";
+         *m_out << "; ";
    }
-   *m_os << std::endl;
+   *m_out << '\n';
    printIndents();
 }
 
@@ -78,16 +80,18 @@ void HaskellPrinter::visit(VarDeclStatement* varDeclStatement)
 
 void HaskellPrinter::visit(AssertStatement* assert)
 {
-   *m_os << "assertEqual \"for " << assert->getMethodName() << ' ';
+   const int* args{assert->getArgs()};
+   const unsigned last{assert->getArity() - 1};
+   *m_out << "assertEqual \"for " << assert->getMethodName() << ' ';
 
-   for (unsigned i=0; i<assert->getParameters().size()-1; ++i)
-      *m_os << assert->getParameters().at(i) << ' ';
-   *m_os << assert->getParameters().back() << ", \" (" << assert->getResult()
+   for (unsigned i=0; i<last; ++i)
+      *m_out << args[i] << ' ';
+   *m_out << args[last] << ", \" (" << assert->getResult()
       << ") (" << assert->getMethodName() << ' ';
 
-   for (unsigned i=0; i<assert->getParameters().size()-1; ++i)
-      *m_os << '(' << assert->getParameters().at(i) << ") ";
-   *m_os << '(' << assert->getParameters().back() << "))";
+   for (unsigned i=0; i<last; ++i)
+      *m_out << '(' << args[i] << ") ";
+   *m_out << '(' << args[last] << "))";
 }
 
 //------------------------------------------------------------------------------------
@@ -109,34 +113,34 @@ void HaskellPrinter::visit(ReturnStatement* returnStatement)
 
 void HaskellPrinter::visit(AssignmentStatement* assignmentStatement)
 {
-   *m_os << '(';
+   *m_out << '(';
    assignmentStatement->getExpression()->accept(this);
-   *m_os << ')';
+   *m_out << ')';
 }
 
 //------------------------------------------------------------------------------------
 
 void HaskellPrinter::visit(IfStatement* ifStatement)
 {
-   *m_os << "if ";
+   *m_out << "if ";
    ifStatement->getExpression()->accept(this);
-   *m_os << std::endl;
+   *m_out << '\n';
    incrementIndents();
    printIndents();
-   *m_os << "then ";
+   *m_out << "then ";
    ifStatement->getThenStatement()->accept(this);
 
    if (ifStatement->getElseStatement()) {
-      *m_os << std::endl; 
+      *m_out << '\n'; 
       printIndents();
-      *m_os << "else ";
+      *m_out << "else ";
       ifStatement->getElseStatement()->accept(this);
       decrementIndents();
    }
    else {
-      *m_os << std::endl;
+      *m_out << '\n';
       printIndents();
-      *m_os << "else do" << std::endl;
+      *m_out << "else do" << '\n';
       incrementIndents();
       printIndents();
    }
@@ -144,41 +148,167 @@ void HaskellPrinter::visit(IfStatement* ifStatement)
 
 //------------------------------------------------------------------------------------
 
+// Haskell has no loops, so a for statement becomes a local function that
+// takes the counter and the method's variables and calls itself with their
+// values after one iteration. The body is made into an ExpressionDag first, so
+// an expression that several of the new values share is bound once with a let
+// rather than written out, and worked out, for each of them.
 void HaskellPrinter::visit(ForStatement* forStatement)
 {
-   *m_os << "let for i a0 a1 an x y" << std::endl; // cop-out
+   ExpressionDag step;
+   Block* body{dynamic_cast<Block*>(forStatement->getBody())};
+   PostfixExpression* updater{forStatement->getUpdaters().size() == 1 ?
+      dynamic_cast<PostfixExpression*>(forStatement->getUpdaters().front()) :
+      nullptr};
+   // Each assignment's variable and the node assigned to it
+   std::vector<std::pair<Name*, int>> assignments;
+   try {
+      if (!body || !updater || forStatement->getInitializers().size() != 1)
+         throw BadArgument{};
+      for (Statement* s : body->getStatements()) {
+         AssignmentStatement* assignment{dynamic_cast<AssignmentStatement*>(s)};
+         if (!assignment) throw BadArgument{};
+         int slot{assignment->getName()->getSlot()};
+         step.assign(slot, assignment->getExpression());
+         assignments.push_back({assignment->getName(), step.valueOf(slot)});
+      }
+      if (assignments.empty()) throw BadArgument{};
+   }
+   catch (BadArgument) {
+      // Not a loop of assignments; all that has been needed is the recurrence
+      *m_out << "let for i a0 a1 an x y" << '\n'; // cop-out
+      incrementIndents();
+      incrementIndents();
+      incrementIndents();
+      printIndents();
+      *m_out << "| ";
+      forStatement->getExpression()->accept(this);
+      *m_out << " = for (i+1) a1 (a0*x + a1*y) (a0*x + a1*y) x y" << '\n';
+      printIndents();
+      *m_out << "| otherwise = an" << '\n';
+      decrementIndents();
+      decrementIndents();
+      decrementIndents();
+      printIndents();
+      *m_out << "let an = for 2 a0 a1 an x y" << '\n';
+      printIndents();
+      return;
+   }
+
+   VarDeclFragment* counter{forStatement->getInitializers().front()};
+   std::vector<Name*> variables;
+   for (Name* name : m_variables)
+      if (name->getSlot() != counter->getLeftOperand()->getSlot())
+         variables.push_back(name);
+
+   // The next values, and the names of the nodes printed as names
+   std::vector<int> next;
+   for (Name* name : variables)
+      next.push_back(step.valueOf(name->getSlot()));
+   std::vector<std::string> names(step.size());
+   for (int id=0; id<step.size(); ++id)
+      if (step.getNode(id).kind == ExpressionDag::Kind::VARIABLE)
+         names[id] = SymbolTable::global().getIdentifier(step.getNode(id).value);
+   std::vector<unsigned> uses;
+   step.countUses(next, uses);
+   std::vector<int> shared;
+   for (int id=0; id<step.size(); ++id) {
+      if (uses[id] < 2 || step.getNode(id).kind != ExpressionDag::Kind::INFIX)
+         continue;
+      for (unsigned a=0; a<assignments.size() && names[id].empty(); ++a)
+         if (assignments[a].second == id)
+            names[id] = assignments[a].first->getName() + '\'';
+      if (names[id].empty()) names[id] = 's' + std::to_string(shared.size() + 1);
+      shared.push_back(id);
+   }
+
+   // The loop's value is that of the first variable it assigns
+   Name* result{assignments.front().first};
+   const std::string& i{counter->getLeftOperand()->getName()};
+   *m_out << "let for " << i;
+   for (Name* name : variables)
+      *m_out << ' ' << name->getName();
+   *m_out << '\n';
    incrementIndents();
    incrementIndents();
    incrementIndents();
    printIndents();
-   *m_os << "| ";
+   *m_out << "| ";
    forStatement->getExpression()->accept(this);
-   *m_os << " = for (i+1) a1 (a0*x + a1*y) (a0*x + a1*y) x y" << std::endl;
+   *m_out << " = ";
+   if (!shared.empty()) {
+      *m_out << "let ";
+      for (unsigned k=0; k<shared.size(); ++k) {
+         // A binding's own name mustn't be used in it
+         std::string name{names[shared[k]]};
+         names[shared[k]].clear();
+         *m_out << (k > 0 ? "; " : "") << name << " = ";
+         printDagNode(step, shared[k], names, 0);
+         names[shared[k]] = name;
+      }
+      *m_out << " in ";
+   }
+   *m_out << "for (" << i
+      << (updater->getOperator() == PostfixOperator::DECREMENT ? "-1)" : "+1)");
+   for (int id : next) {
+      *m_out << ' ';
+      printDagNode(step, id, names, ARGUMENT_PRECEDENCE);
+   }
+   *m_out << '\n';
    printIndents();
-   *m_os << "| otherwise = an" << std::endl;
+   *m_out << "| otherwise = " << result->getName() << '\n';
    decrementIndents();
    decrementIndents();
    decrementIndents();
    printIndents();
-   *m_os << "let an = for 2 a0 a1 an x y" << std::endl;
+   *m_out << "let " << result->getName() << " = for ";
+   counter->getRightOperand()->accept(this);
+   for (Name* name : variables)
+      *m_out << ' ' << name->getName();
+   *m_out << '\n';
    printIndents();
 }
 
 //------------------------------------------------------------------------------------
 
+// Prints node id of dag, in parentheses if it is an operation that binds less
+// tightly than outer. Nodes with a name are printed as it.
+void HaskellPrinter::printDagNode(const ExpressionDag& dag, int id,
+      const std::vector<std::string>& names, int outer)
+{
+   const ExpressionDag::Node& node = dag.getNode(id);
+   if (!names.at(id).empty()) {
+      *m_out << names[id];
+      return;
+   }
+   if (node.kind == ExpressionDag::Kind::CONSTANT) {
+      if (node.value < 0 && outer > 0) *m_out << '(' << node.value << ')';
+      else *m_out << node.value;
+      return;
+   }
+   int precedence{node.op == InfixOperator::TIMES ? 7 : 6};
+   if (precedence < outer) *m_out << '(';
+   printDagNode(dag, node.left, names, precedence);
+   *m_out << ' ' << Haskell::infixOp(node.op) << ' ';
+   // + and * are left associative
+   printDagNode(dag, node.right, names, precedence + 1);
+   if (precedence < outer) *m_out << ')';
+}
+
+//------------------------------------------------------------------------------------
+
 void HaskellPrinter::visit(BooleanLiteral* booleanLiteral)
 {
    if (booleanLiteral->booleanValue() == true)
-      *m_os << "True";
-   else *m_os << "False";
+      *m_out << "True";
+   else *m_out << "False";
 }
 
 //------------------------------------------------------------------------------------
 
 void HaskellPrinter::visit(NumberLiteral* numberLiteral)
 {
-   std::string token{numberLiteral->getToken()};
-   *m_os << token;
+   printNumber(numberLiteral);
 }
 
 //------------------------------------------------------------------------------------
@@ -187,7 +317,7 @@ void HaskellPrinter::visit(NumberLiteral* numberLiteral)
 void HaskellPrinter::visit(InfixExpression* infixExpression)
 {
    infixExpression->getLeftOperand()->accept(this);
-   *m_os << ' ' << infixOpToString(infixExpression->getOperator()) << ' ';
+   *m_out << ' ' << Haskell::infixOp(infixExpression->getOperator()) << ' ';
    infixExpression->getRightOperand()->accept(this);
 }
 
@@ -201,7 +331,8 @@ void HaskellPrinter::visit(PostfixExpression* postfixExpression)
 
 void HaskellPrinter::visit(VarDeclFragment* varDeclFragment)
 {
+   m_variables.push_back(varDeclFragment->getLeftOperand());
    varDeclFragment->getLeftOperand()->accept(this);
-   *m_os << " = ";
+   *m_out << " = ";
    varDeclFragment->getRightOperand()->accept(this);
 }
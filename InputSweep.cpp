@@ -0,0 +1,239 @@
+#include "AST.h"
+#include <functional>
+#include <thread>
+
+// Writes input number index of a sweep to args, one value per parameter, and
+// returns the number of inputs of the domain that it stands for.
+typedef std::function<unsigned long long(unsigned long long index, int* args)>
+   InputSource;
+
+//------------------------------------------------------------------------------------
+
+static void addReturns(Statement* statement,
+      std::vector<const ReturnStatement*>& returns)
+{
+   if (Block* block = dynamic_cast<Block*>(statement)) {
+      for (Statement* s : block->getStatements())
+         addReturns(s, returns);
+   }
+   else if (IfStatement* ifStatement = dynamic_cast<IfStatement*>(statement)) {
+      addReturns(ifStatement->getThenStatement(), returns);
+      if (ifStatement->getElseStatement())
+         addReturns(ifStatement->getElseStatement(), returns);
+   }
+   else if (ForStatement* forStatement = dynamic_cast<ForStatement*>(statement))
+      addReturns(forStatement->getBody(), returns);
+   else if (ReturnStatement* returnStatement =
+         dynamic_cast<ReturnStatement*>(statement))
+      returns.push_back(returnStatement);
+}
+
+//------------------------------------------------------------------------------------
+
+static MethodDeclaration* sweptMethod(Boilerplate* program)
+{
+   if (program->getBodyDeclarations().size() != 1) throw BadArgument{};
+   MethodDeclaration* method{
+      dynamic_cast<MethodDeclaration*>(program->getBodyDeclarations().front())};
+   if (!method) throw BadArgument{};
+   return method;
+}
+
+//------------------------------------------------------------------------------------
+
+static SweepReport emptyReport(MethodDeclaration* method)
+{
+   SweepReport report;
+   addReturns(method->getBody(), report.returns);
+   report.returnHits.assign(report.returns.size(), 0);
+   report.firstInputs.resize(report.returns.size());
+   return report;
+}
+
+//------------------------------------------------------------------------------------
+
+static void keepFirst(std::vector<int>& first, const int* input, unsigned size)
+{
+   if (first.empty() ||
+         std::lexicographical_compare(input, input + size, first.begin(), first.end()))
+      first.assign(input, input + size);
+}
+
+//------------------------------------------------------------------------------------
+
+// Evaluates inputs begin to end - 1 of source and adds them to report
+static void sweepRange(Boilerplate* program, unsigned numberParams,
+      const InputSource& source, unsigned long long begin, unsigned long long end,
+      SweepReport& report)
+{
+   BatchEvaluator evaluator;
+   std::vector<std::vector<int>> lanes(numberParams, std::vector<int>(BATCH_LANES));
+   std::vector<const int*> inputs;
+   for (const std::vector<int>& l : lanes) inputs.push_back(l.data());
+   // The inputs of lane i are args[i * numberParams] onwards
+   std::vector<int> args(BATCH_LANES * numberParams);
+   unsigned long long weights[BATCH_LANES];
+   int results[BATCH_LANES];
+   const ReturnStatement* returnedBy[BATCH_LANES];
+
+   for (unsigned long long first=begin; first < end; first += BATCH_LANES) {
+      unsigned count{static_cast<unsigned>(
+            std::min<unsigned long long>(BATCH_LANES, end - first))};
+      for (unsigned i=0; i<BATCH_LANES; ++i) {
+         int* laneArgs{args.data() + i * numberParams};
+         // Spare lanes of the last batch repeat its first input
+         if (i < count) weights[i] = source(first + i, laneArgs);
+         else std::copy(args.data(), args.data() + numberParams, laneArgs);
+         for (unsigned j=0; j<numberParams; ++j) lanes[j][i] = laneArgs[j];
+      }
+      evaluator.evaluate(program, inputs, results, returnedBy);
+
+      for (unsigned i=0; i<count; ++i) {
+         if (weights[i] == 0) continue;
+         unsigned r{static_cast<unsigned>(std::find(report.returns.begin(),
+                  report.returns.end(), returnedBy[i]) - report.returns.begin())};
+         report.numberInputs += weights[i];
+         report.histogram[results[i]] += weights[i];
+         report.returnHits.at(r) += weights[i];
+         keepFirst(report.firstInputs.at(r), args.data() + i * numberParams,
+               numberParams);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+static SweepReport sweep(Boilerplate* program, const InputSource& source,
+      unsigned long long numberSources, unsigned numberThreads)
+{
+   MethodDeclaration* method{sweptMethod(program)};
+   const std::vector<Parameter>& params = method->getParamList();
+   // The threads only read the symbol table, so every name has to be in it first
+   for (const Parameter& p : params)
+      SymbolTable::global().intern(p.name);
+
+   // Each thread takes a run of whole batches
+   unsigned long long numberBatches{(numberSources + BATCH_LANES - 1) / BATCH_LANES};
+   if (numberThreads == 0) numberThreads = std::thread::hardware_concurrency();
+   numberThreads = std::max<unsigned long long>(1,
+         std::min<unsigned long long>(numberThreads, numberBatches));
+   std::vector<SweepReport> partial(numberThreads, emptyReport(method));
+   std::vector<std::exception_ptr> errors(numberThreads);
+   auto sweepPart = [&](unsigned t) {
+      unsigned long long begin{numberBatches * t / numberThreads * BATCH_LANES};
+      unsigned long long end{std::min(numberSources,
+            numberBatches * (t + 1) / numberThreads * BATCH_LANES)};
+      try {
+         sweepRange(program, params.size(), source, begin, end, partial.at(t));
+      }
+      catch (...) {
+         errors.at(t) = std::current_exception();
+      }
+   };
+   if (numberThreads == 1) sweepPart(0);
+   else {
+      std::vector<std::thread> threads;
+      for (unsigned t=0; t<numberThreads; ++t)
+         threads.push_back(std::thread{sweepPart, t});
+      for (std::thread& thread : threads)
+         thread.join();
+   }
+   for (std::exception_ptr& e : errors)
+      if (e) std::rethrow_exception(e);
+
+   SweepReport report{emptyReport(method)};
+   for (const SweepReport& part : partial) {
+      report.numberInputs += part.numberInputs;
+      for (const std::pair<const int, unsigned long long>& h : part.histogram)
+         report.histogram[h.first] += h.second;
+      for (unsigned r=0; r<report.returns.size(); ++r) {
+         report.returnHits.at(r) += part.returnHits.at(r);
+         if (!part.firstInputs.at(r).empty())
+            keepFirst(report.firstInputs.at(r), part.firstInputs.at(r).data(),
+                  params.size());
+      }
+   }
+   return report;
+}
+
+//------------------------------------------------------------------------------------
+
+bool SweepReport::allReturnsReached() const
+{
+   return std::all_of(returnHits.begin(), returnHits.end(),
+         [](unsigned long long hits) { return hits > 0; });
+}
+
+//------------------------------------------------------------------------------------
+
+SweepReport sweepInputDomain(Boilerplate* program, int range,
+      unsigned numberThreads)
+{
+   if (range < 0) throw BadArgument{};
+   const unsigned numberParams{static_cast<unsigned>(
+         sweptMethod(program)->getParamList().size())};
+
+   DecisionTable table;
+   bool haveTable{false};
+   try {
+      haveTable = table.build(program);
+   }
+   catch (BadSize) {} // too many cells, so every input is run instead
+   if (haveTable) {
+      // Cell k of parameter j holds the values in (t[k-1], t[k]], t being its
+      // thresholds; each cell is run once on the first of its values that is
+      // in the domain, and counted for all of them.
+      const std::vector<std::vector<int>>& thresholds = table.getThresholds();
+      InputSource cells = [&thresholds, range](unsigned long long cell, int* args) {
+         unsigned long long weight{1};
+         for (unsigned j=0; j<thresholds.size(); ++j) {
+            const std::vector<int>& t = thresholds.at(j);
+            unsigned k{static_cast<unsigned>(cell % (t.size() + 1))};
+            cell /= t.size() + 1;
+            long long low{k == 0 ? -range :
+               std::max<long long>(-range, t.at(k - 1) + 1LL)};
+            long long high{k == t.size() ? range :
+               std::min<long long>(range, t.at(k))};
+            if (low > high) {
+               low = high = -range;
+               weight = 0;
+            }
+            args[j] = low;
+            weight *= high - low + 1;
+         }
+         return weight;
+      };
+      return sweep(program, cells, table.numberCells(), 1);
+   }
+
+   // Input number index, with the first parameter varying slowest
+   const unsigned long long side{2ULL * range + 1};
+   unsigned long long numberInputs{1};
+   for (unsigned j=0; j<numberParams; ++j)
+      if (__builtin_mul_overflow(numberInputs, side, &numberInputs)) throw BadSize{};
+   InputSource domain = [side, range, numberParams](unsigned long long index,
+         int* args) {
+      for (unsigned j=numberParams; j-- > 0; ) {
+         args[j] = static_cast<int>(index % side) - range;
+         index /= side;
+      }
+      return 1ULL;
+   };
+   return sweep(program, domain, numberInputs, numberThreads);
+}
+
+//------------------------------------------------------------------------------------
+
+SweepReport sweepInputs(Boilerplate* program,
+      const std::vector<std::vector<int>>& inputs, unsigned numberInputs)
+{
+   if (inputs.size() != sweptMethod(program)->getParamList().size())
+      throw BadSize{};
+   for (const std::vector<int>& v : inputs)
+      if (v.size() < numberInputs) throw BadSize{};
+   InputSource given = [&inputs](unsigned long long index, int* args) {
+      for (unsigned j=0; j<inputs.size(); ++j) args[j] = inputs[j][index];
+      return 1ULL;
+   };
+   return sweep(program, given, numberInputs, 1);
+}
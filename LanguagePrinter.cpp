@@ -0,0 +1,317 @@
+#include "AST.h"
+
+template <> void LanguagePrinter<Java>::visit(TesterBoilerplate* tester)
+{  // Temporary fix
+   *m_out << "import static org.junit.Assert.*;" << '\n';
+   *m_out << "import org.junit.BeforeClass;" << '\n';
+   *m_out << "import org.junit.Test;" << '\n';
+   *m_out << "import " << tester->getPackageName() << '.' << tester->getClassName()
+      << ';' << '\n';
+   *m_out << "public class " << tester->getName() << " {" << '\n';
+   incrementIndents();
+   printIndents();
+   *m_out << "private static " << tester->getClassName() << " tester;" << '\n';
+   printIndents();
+   *m_out << "@BeforeClass" << '\n';
+   printIndents();
+   *m_out << "public static void setUp() {" << '\n';
+   incrementIndents();
+   printIndents();
+   *m_out << "tester = new " << tester->getClassName() << "();" << '\n';
+   decrementIndents();
+   printIndents();
+   *m_out << '}' << '\n';
+   printIndents();
+   *m_out << "@Test" << '\n';
+   printIndents();
+   *m_out << "public void " << tester->getMethodName() << "Test() {" << '\n';
+   incrementIndents();
+   for (unsigned i=0; i<tester->getAsserts().size(); ++i) {
+      printIndents();
+      AssertStatement as{tester->getAsserts(), i};
+      dispatch(&as, *this);
+   }
+   decrementIndents();
+   printIndents();
+   *m_out << '}' << '\n';
+   decrementIndents();
+   printIndents();
+   *m_out << '}' << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<Java>::visit(Boilerplate* boilerplate)
+{
+   printIndents();
+   *m_out << "package " << boilerplate->getName(0) << ';' << '\n';
+   printIndents();
+   *m_out << "public class " << boilerplate->getName(1) << " {" << '\n';
+   incrementIndents();
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      dispatch(d, *this);   
+
+   decrementIndents();
+   *m_out << '}' << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<Java>::visit(MethodDeclaration* methodDeclaration)
+{
+   printIndents();
+   *m_out << "public " << Java::typeName(methodDeclaration->getReturnType()) << ' '
+      << methodDeclaration->getName() << '(';
+   
+   // If statement formats argument list so it's (int x, int y, char z, ...),
+   // or "()" if there are no arguments
+   if (methodDeclaration->getParamList().size() > 0) {
+      using size_type = std::vector<Parameter>::size_type;
+      for (size_type i = 0; i<methodDeclaration->getParamList().size()-1; ++i) {
+            const Parameter& p = methodDeclaration->getParamList().at(i);
+            *m_out << Java::typeName(p.type) << ' ' << p.name << ", ";
+      }
+
+      const Parameter& p = methodDeclaration->getParamList().back();
+      *m_out << Java::typeName(p.type) << ' ' << p.name; 
+   }
+   *m_out << ") ";
+
+   dispatch(methodDeclaration->getBody(), *this);
+   *m_out << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<Java>::visit(AssertStatement* assert)
+{
+   *m_out << "assertEquals(\"" << assert->getMethodName() << '(';
+   printIntVector(assert->getArgs(), assert->getArity());
+   *m_out << ") must be " << assert->getResult() << "\", " << assert->getResult() << 
+      ", tester." << assert->getMethodName() << '(';
+   printIntVector(assert->getArgs(), assert->getArity());
+   *m_out << "));" << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<JavaScript>::visit(TesterBoilerplate* tester)
+{
+   *m_out << "load(\"assert.js\");" << '\n';
+   *m_out << "load(\"" << tester->getPackageName() << '/' << tester->getClassName()
+     << ".js\");" << '\n';
+   *m_out << "var " << tester->getMethodName() << "Test = function () {" << '\n';
+   incrementIndents();
+   printIndents();
+   *m_out << "try {" << '\n';
+   incrementIndents();
+   for (unsigned i=0; i<tester->getAsserts().size(); ++i) {
+      printIndents();
+      AssertStatement as{tester->getAsserts(), i};
+      dispatch(&as, *this);
+   }
+   printIndents();
+   *m_out << "print('Tests passed!')" << '\n';
+   decrementIndents();
+   *m_out << "} catch (e) {" << '\n';
+   incrementIndents();
+   printIndents();
+   *m_out << "print(e.name + ': ' + e.message);" << '\n';
+   decrementIndents();
+   printIndents();
+   *m_out << '}' << '\n';
+   decrementIndents();
+   printIndents();
+   *m_out << '}' << '\n' << '\n';
+   printIndents();
+   *m_out << tester->getMethodName() << "Test();" << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<JavaScript>::visit(Boilerplate* boilerplate)
+{
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      dispatch(d, *this);
+}
+
+//------------------------------------------------------------------------------------
+
+template <> 
+void LanguagePrinter<JavaScript>::visit(MethodDeclaration* methodDeclaration)
+{
+   printIndents();
+   *m_out << "function " << methodDeclaration->getName() << '(';
+   if (methodDeclaration->getParamList().size() > 0) {
+      for (unsigned i=0; i<methodDeclaration->getParamList().size()-1; ++i) {
+         const Parameter& p = methodDeclaration->getParamList().at(i);
+         *m_out << p.name << ", ";
+      }
+
+      const Parameter& p = methodDeclaration->getParamList().back();
+      *m_out << ' ' << p.name;
+   }
+   *m_out << ") ";
+
+   dispatch(methodDeclaration->getBody(), *this);
+   *m_out << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <> void LanguagePrinter<JavaScript>::visit(AssertStatement* assert)
+{
+   // assert(Rec(2) === 6, "Rec(2) must be 6");
+   *m_out << "assert(" << assert->getMethodName() << '(';
+   printIntVector(assert->getArgs(), assert->getArity());
+   *m_out << ") === " << assert->getResult() << ", \"" << assert->getMethodName()
+      << '(';
+   printIntVector(assert->getArgs(), assert->getArity());
+   *m_out << ") must be " << assert->getResult() << "\");" << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(VarDeclStatement* varDeclStatement)
+{
+   *m_out << Language::typeName(varDeclStatement->getType()) << ' ';
+   for (unsigned i=0; i<varDeclStatement->getFragments().size(); ++i) {
+      dispatch(varDeclStatement->getFragments().at(i), *this);
+      if (i != varDeclStatement->getFragments().size() - 1)
+         *m_out << ", ";
+   }
+   *m_out << ';' << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(Block* block)
+{
+   *m_out << '{' << '\n';
+
+   incrementIndents();
+   // Print all the statements in the block (if any).
+   // As of now all Indent printing is done by visiting Block.
+   // If, for example, a thenStatement* or elseStatement* belonging to an 
+   // ifStatement happen to not be blocks, then those statements are printed on
+   // the same line as the "if (expression)" or "else", respectively.
+   for (Statement* statement : block->getStatements()) {
+      printIndents();
+      dispatch(statement, *this);
+   }
+   decrementIndents();
+
+   printIndents();
+   *m_out << '}';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(ReturnStatement* returnStatement)
+{
+   *m_out << "return ";
+   dispatch(returnStatement->getExpression(), *this);
+   *m_out << ';' << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(AssignmentStatement* assignmentStatement)
+{ 
+   dispatch(assignmentStatement->getName(), *this);
+   *m_out << " = ";
+   dispatch(assignmentStatement->getExpression(), *this);
+   *m_out << ';' << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(IfStatement* ifStatement)
+{
+   *m_out << "if (";
+   dispatch(ifStatement->getExpression(), *this); // print expression
+   *m_out << ") ";
+   dispatch(ifStatement->getThenStatement(), *this);
+   
+   if (ifStatement->getElseStatement()) {
+      *m_out << " else ";
+      dispatch(ifStatement->getElseStatement(), *this);
+      *m_out << '\n';
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(ForStatement* forStatement)
+{
+   *m_out << Language::forKeyword();
+   if (!forStatement->getInitializers().empty())
+      *m_out << Language::typeName(forStatement->getInitializers().at(0)->getType()) 
+         << ' ';
+   for (Expression* e : forStatement->getInitializers()) dispatch(e, *this);
+   *m_out << "; ";
+   dispatch(forStatement->getExpression(), *this);
+   *m_out << "; ";
+   for (Expression* e : forStatement->getUpdaters()) dispatch(e, *this);
+   *m_out << ") ";
+   dispatch(forStatement->getBody(), *this);
+   *m_out << '\n';
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(BooleanLiteral* booleanLiteral)
+{
+   if (booleanLiteral->booleanValue() == true)
+      *m_out << "true";
+   else *m_out << "false";
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(NumberLiteral* numberLiteral)
+{
+   printNumber(numberLiteral);
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(InfixExpression* infixExpression)
+{
+   dispatch(infixExpression->getLeftOperand(), *this);
+   *m_out << ' ' << Language::infixOp(infixExpression->getOperator()) << ' ';
+   dispatch(infixExpression->getRightOperand(), *this);
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(PostfixExpression* postfixExpression)
+{
+   dispatch(postfixExpression->getLeftOperand(), *this);
+   *m_out << Language::postfixOp(postfixExpression->getOperator());
+}
+
+//------------------------------------------------------------------------------------
+
+template <typename Language>
+void LanguagePrinter<Language>::visit(VarDeclFragment* varDeclFragment)
+{
+   dispatch(varDeclFragment->getLeftOperand(), *this);
+   *m_out << " = ";
+   dispatch(varDeclFragment->getRightOperand(), *this);
+}
+
+//------------------------------------------------------------------------------------
+
+template struct LanguagePrinter<Java>;
+template struct LanguagePrinter<JavaScript>;
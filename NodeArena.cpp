@@ -0,0 +1,138 @@
+#include "AST.h"
+#include <new>
+
+// Where a node's memory came from. It is kept in a header just in front of the
+// node, so that operator delete knows what to do with it.
+enum class NodeStorage : unsigned char { HEAP, ARENA, SHARED };
+
+// The header keeps the node after it aligned for any type
+static const std::size_t HEADER_SIZE{alignof(std::max_align_t)};
+
+static thread_local NodeArena* currentArena{nullptr};
+
+unsigned long long NodeArena::m_totalPrograms{0};
+unsigned long long NodeArena::m_totalNodes{0};
+unsigned long long NodeArena::m_totalBytes{0};
+std::size_t NodeArena::m_largestProgram{0};
+
+//------------------------------------------------------------------------------------
+
+NodeArena::~NodeArena()
+{
+   addToTotals();
+   for (char* chunk : m_chunks)
+      ::operator delete(chunk);
+}
+
+//------------------------------------------------------------------------------------
+
+void* NodeArena::allocate(std::size_t size)
+{
+   size = (size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+   if (size > static_cast<std::size_t>(m_end - m_next)) {
+      // What is left of the last chunk is wasted
+      std::size_t chunkSize{std::max(size, m_chunkSize)};
+      m_chunks.push_back(static_cast<char*>(::operator new(chunkSize)));
+      m_next = m_chunks.back();
+      m_end = m_next + chunkSize;
+   }
+   void* memory{m_next};
+   m_next += size;
+   m_bytes += size;
+   ++m_nodes;
+   return memory;
+}
+
+//------------------------------------------------------------------------------------
+
+void NodeArena::reset()
+{
+   addToTotals();
+   if (m_chunks.size() > 1) {
+      for (unsigned i=1; i<m_chunks.size(); ++i)
+         ::operator delete(m_chunks.at(i));
+      m_chunks.resize(1);
+   }
+   m_next = m_chunks.empty() ? nullptr : m_chunks.front();
+   m_end = m_chunks.empty() ? nullptr : m_next + m_chunkSize;
+   m_bytes = 0;
+   m_nodes = 0;
+}
+
+//------------------------------------------------------------------------------------
+
+void NodeArena::addToTotals()
+{
+   // A shared arena holds nodes of many programs, and an empty one none
+   if (m_shared || m_nodes == 0) return;
+   ++m_totalPrograms;
+   m_totalNodes += m_nodes;
+   m_totalBytes += m_bytes;
+   m_largestProgram = std::max(m_largestProgram, m_bytes);
+}
+
+//------------------------------------------------------------------------------------
+
+NodeArena* NodeArena::current()
+{
+   return currentArena;
+}
+
+//------------------------------------------------------------------------------------
+
+ArenaScope::ArenaScope(NodeArena& arena)
+   :m_previous{currentArena}
+{
+   currentArena = &arena;
+}
+
+//------------------------------------------------------------------------------------
+
+ArenaScope::~ArenaScope()
+{
+   currentArena = m_previous;
+}
+
+//------------------------------------------------------------------------------------
+
+void* ASTNode::operator new(std::size_t size)
+{
+   char* memory;
+   NodeStorage storage;
+   if (currentArena) {
+      memory = static_cast<char*>(currentArena->allocate(HEADER_SIZE + size));
+      storage = currentArena->isShared() ? NodeStorage::SHARED : NodeStorage::ARENA;
+   }
+   else {
+      memory = static_cast<char*>(::operator new(HEADER_SIZE + size));
+      storage = NodeStorage::HEAP;
+   }
+   new (memory) NodeStorage{storage};
+   return memory + HEADER_SIZE;
+}
+
+//------------------------------------------------------------------------------------
+
+void ASTNode::operator delete(void* node)
+{
+   if (!node) return;
+   char* memory{static_cast<char*>(node) - HEADER_SIZE};
+   // Arena memory is given back by its arena
+   if (*reinterpret_cast<NodeStorage*>(memory) == NodeStorage::HEAP)
+      ::operator delete(memory);
+}
+
+//------------------------------------------------------------------------------------
+
+bool ASTNode::isShared(const ASTNode* node)
+{
+   const char* memory{reinterpret_cast<const char*>(node) - HEADER_SIZE};
+   return *reinterpret_cast<const NodeStorage*>(memory) == NodeStorage::SHARED;
+}
+
+//------------------------------------------------------------------------------------
+
+void ASTNode::release(ASTNode* node)
+{
+   if (node && !isShared(node)) delete node;
+}
@@ -0,0 +1,75 @@
+#include "AST.h"
+
+NodeFactory& NodeFactory::global()
+{
+   static NodeFactory nodeFactory;
+   return nodeFactory;
+}
+
+//------------------------------------------------------------------------------------
+
+NodeFactory::~NodeFactory()
+{
+   // Children are shared, so deleting a node leaves them be
+   for (ASTNode* node : m_nodes)
+      delete node;
+}
+
+//------------------------------------------------------------------------------------
+
+// Returns the node nodes has for key, first making it from args if there is none
+template <typename T, typename Key, typename... Args>
+T* NodeFactory::find(std::map<Key, T*>& nodes, const Key& key, Args&&... args)
+{
+   ++m_requests;
+   m_requestedBytes += sizeof(T);
+   auto found = nodes.find(key);
+   if (found != nodes.end()) return found->second;
+   T* node;
+   {
+      ArenaScope scope{m_arena};
+      node = new T{std::forward<Args>(args)...};
+   }
+   m_nodes.push_back(node);
+   m_bytes += sizeof(T);
+   nodes.emplace(key, node);
+   return node;
+}
+
+//------------------------------------------------------------------------------------
+
+Name* NodeFactory::name(const std::string& identifier)
+{
+   return find(m_names, identifier, identifier);
+}
+
+//------------------------------------------------------------------------------------
+
+NumberLiteral* NodeFactory::number(int value)
+{
+   return find(m_numbers, value, value);
+}
+
+//------------------------------------------------------------------------------------
+
+BooleanLiteral* NodeFactory::boolean(bool value)
+{
+   return find(m_booleans, value, value);
+}
+
+//------------------------------------------------------------------------------------
+
+InfixExpression* NodeFactory::infix(Expression* left, InfixOperator op,
+      Expression* right)
+{
+   if (!ASTNode::isShared(left) || !ASTNode::isShared(right)) throw BadArgument{};
+   return find(m_infixes, std::make_tuple(left, op, right), left, op, right);
+}
+
+//------------------------------------------------------------------------------------
+
+PostfixExpression* NodeFactory::postfix(Expression* operand, PostfixOperator op)
+{
+   if (!ASTNode::isShared(operand)) throw BadArgument{};
+   return find(m_postfixes, std::make_pair(operand, op), operand, op);
+}
@@ -0,0 +1,65 @@
+#include "AST.h"
+
+unsigned long long OutputSink::m_totalFlushes{0};
+unsigned long long OutputSink::m_totalBytes{0};
+
+//------------------------------------------------------------------------------------
+
+void OutputSink::flush()
+{
+   if (!m_os || m_buffer.empty()) return;
+   m_os->write(m_buffer.data(), m_buffer.size());
+   ++m_flushes;
+   ++m_totalFlushes;
+   m_bytes += m_buffer.size();
+   m_totalBytes += m_buffer.size();
+   // clear() keeps the capacity, so the next file is printed without growing it
+   m_buffer.clear();
+}
+
+//------------------------------------------------------------------------------------
+
+void OutputSink::setStream(std::ostream& os)
+{
+   flush();
+   m_os = &os;
+}
+
+//------------------------------------------------------------------------------------
+
+// Writes the digits of i backwards from end, and returns where they start
+static char* formatDigits(unsigned i, char* end)
+{
+   do {
+      *--end = static_cast<char>('0' + i % 10);
+      i /= 10;
+   } while (i != 0);
+   return end;
+}
+
+//------------------------------------------------------------------------------------
+
+// Integers are formatted by hand rather than through std::to_string(), which
+// makes a string, or an ostream, which goes through the locale
+OutputSink& OutputSink::operator<<(int i)
+{
+   char digits[std::numeric_limits<unsigned>::digits10 + 2];
+   char* end{digits + sizeof digits};
+   // -i isn't an int when i is the smallest int, but it is an unsigned
+   unsigned magnitude{i < 0 ? 0u - static_cast<unsigned>(i) : 
+      static_cast<unsigned>(i)};
+   char* begin{formatDigits(magnitude, end)};
+   if (i < 0) *--begin = '-';
+   m_buffer.append(begin, end);
+   return *this;
+}
+
+//------------------------------------------------------------------------------------
+
+OutputSink& OutputSink::operator<<(unsigned i)
+{
+   char digits[std::numeric_limits<unsigned>::digits10 + 1];
+   char* end{digits + sizeof digits};
+   m_buffer.append(formatDigits(i, end), end);
+   return *this;
+}
@@ -0,0 +1,175 @@
+#include "AST.h"
+
+std::vector<int> ProgramShape::getNumbers() const
+{
+   std::vector<int> numbers;
+   numbers.reserve(m_literals.size());
+   for (NumberLiteral* numberLiteral : m_literals)
+      numbers.push_back(numberLiteral->getValue());
+   return numbers;
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::add(std::uint64_t value)
+{
+   m_hasher.add(value);
+   m_description.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+//------------------------------------------------------------------------------------
+
+// The length keeps e.g. names "ab", "c" apart from "a", "bc"
+void ProgramShape::add(const std::string& s)
+{
+   m_hasher.add(s);
+   std::uint64_t size{s.size()};
+   m_description.append(reinterpret_cast<const char*>(&size), sizeof size);
+   m_description += s;
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(Boilerplate* boilerplate)
+{
+   add(boilerplate->getNames().size());
+   for (const std::string& name : boilerplate->getNames())
+      add(name);
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(MethodDeclaration* methodDeclaration)
+{
+   add(methodDeclaration->getName());
+   add(static_cast<std::uint64_t>(methodDeclaration->getReturnType()));
+   add(methodDeclaration->getParamList().size());
+   for (const Parameter& p : methodDeclaration->getParamList()) {
+      add(static_cast<std::uint64_t>(p.type));
+      add(p.name);
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(VarDeclStatement* varDeclStatement)
+{
+   add(static_cast<std::uint64_t>(varDeclStatement->getType()));
+}
+
+//------------------------------------------------------------------------------------
+
+// Slots stand for identifiers within a run, which is as long as templates last
+void ProgramShape::describe(Name* name)
+{
+   add(static_cast<std::uint64_t>(name->getSlot()));
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(BooleanLiteral* booleanLiteral)
+{
+   add(booleanLiteral->booleanValue());
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(InfixExpression* infixExpression)
+{
+   add(static_cast<std::uint64_t>(infixExpression->getOperator()));
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(PostfixExpression* postfixExpression)
+{
+   add(static_cast<std::uint64_t>(postfixExpression->getOperator()));
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramShape::describe(VarDeclFragment* varDeclFragment)
+{
+   add(static_cast<std::uint64_t>(varDeclFragment->getType()));
+}
+
+//------------------------------------------------------------------------------------
+
+OutputTemplate::OutputTemplate(Printer& printer, Boilerplate* program)
+{
+   // A literal can be in more than one place in the program (see NodeFactory),
+   // so a copy of it, whose literals are their own numbers, is printed
+   Boilerplate* copy{FlatTree{program}.toAST()};
+   ProgramShape shape{copy};
+   for (unsigned i=0; i<shape.getLiterals().size(); ++i)
+      shape.getLiterals().at(i)->setValue(i);
+
+   OutputSink sink;
+   OutputSink* out{printer.m_out};
+   printer.m_out = &sink;
+   printer.m_template = this;
+   try {
+      copy->accept(&printer);
+   }
+   catch (...) {
+      printer.m_out = out;
+      printer.m_template = nullptr;
+      delete copy;
+      throw;
+   }
+   printer.m_out = out;
+   printer.m_template = nullptr;
+   delete copy;
+   m_text = sink.getBuffer();
+
+   // Fillable if each literal has exactly one hole
+   m_shape = shape.getDescription();
+   std::vector<unsigned> holesOf(shape.getLiterals().size());
+   for (const Hole& hole : m_holes)
+      if (hole.number < holesOf.size()) ++holesOf.at(hole.number);
+   m_fillable = m_holes.size() == holesOf.size();
+   for (unsigned holes : holesOf)
+      if (holes != 1) m_fillable = false;
+}
+
+//------------------------------------------------------------------------------------
+
+void OutputTemplate::addHole(const OutputSink& sink, int number)
+{
+   m_holes.push_back(Hole{sink.getBuffer().size(), static_cast<unsigned>(number)});
+}
+
+//------------------------------------------------------------------------------------
+
+void OutputTemplate::fill(const std::vector<int>& numbers, OutputSink& sink) const
+{
+   std::size_t from{0};
+   for (const Hole& hole : m_holes) {
+      sink.append(m_text.data() + from, hole.at - from);
+      sink << numbers.at(hole.number);
+      from = hole.at;
+   }
+   sink.append(m_text.data() + from, m_text.size() - from);
+}
+
+//------------------------------------------------------------------------------------
+
+void Printer::printByTemplate(Boilerplate* program)
+{
+   ProgramShape shape{program};
+   auto found = m_templates.find(shape.getHash());
+   if (found == m_templates.end())
+      found = m_templates.emplace(shape.getHash(), 
+            OutputTemplate{*this, program}).first;
+   if (found->second.fits(shape.getDescription()))
+      found->second.fill(shape.getNumbers(), *m_out);
+   else program->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void Printer::printNumber(const NumberLiteral* numberLiteral)
+{
+   if (m_template) m_template->addHole(*m_out, numberLiteral->getValue());
+   else *m_out << numberLiteral->getValue();
+}
@@ -0,0 +1,409 @@
+#include "AST.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[4]{'S', 'E', 'A', 'S'};
+
+// Where keepProgramFile() writes, if anywhere
+static boost::filesystem::path programFileDirectory;
+
+//------------------------------------------------------------------------------------
+
+// Lays a FlatTree of a program, and its tester, out as a program file
+struct ProgramFileWriter {
+   ProgramFileWriter(Boilerplate* program, TesterBoilerplate* tester);
+
+   void write(const boost::filesystem::path& path) const;
+private:
+   // Each identifier is written once
+   std::uint32_t string(const std::string& s);
+
+   template <typename T> void append(const T* data, std::size_t number)
+   {
+      const char* bytes{reinterpret_cast<const char*>(data)};
+      m_file.insert(m_file.end(), bytes, bytes + number * sizeof(T));
+   }
+   template <typename T> void append(const std::vector<T>& v)
+   {
+      append(v.data(), v.size());
+   }
+
+   MappedProgram::Header m_header;
+   std::vector<char> m_file;
+   std::unordered_map<std::string, std::uint32_t> m_stringIds;
+   std::vector<std::uint32_t> m_strings;
+   std::vector<char> m_chars;
+};
+
+//------------------------------------------------------------------------------------
+
+ProgramFileWriter::ProgramFileWriter(Boilerplate* program, TesterBoilerplate* tester)
+{
+   FlatTree tree{program};
+   std::vector<std::int32_t> values;
+   std::vector<std::uint32_t> ends, nameLists, nameIds;
+   std::vector<MappedProgram::Method> methods;
+   std::vector<MappedProgram::Param> params;
+   std::vector<std::uint8_t> kinds;
+   // The FlatTree's names and methods are numbered again in the order in which
+   // their nodes come
+   for (std::uint32_t node=0; node<tree.size(); ++node) {
+      int value{tree.getValue(node)};
+      switch (tree.getKind(node)) {
+         case NodeKind::BOILERPLATE:
+            nameLists.push_back(nameIds.size());
+            for (const std::string& name : tree.getNames(value))
+               nameIds.push_back(string(name));
+            value = nameLists.size() - 1;
+            break;
+         case NodeKind::METHOD_DECLARATION: {
+            const FlatTree::Method& method = tree.getMethod(value);
+            methods.push_back(MappedProgram::Method{string(method.name),
+                  static_cast<std::uint32_t>(method.returnType),
+                  static_cast<std::uint32_t>(params.size()),
+                  static_cast<std::uint32_t>(method.params.size())});
+            for (const Parameter& p : method.params)
+               params.push_back(MappedProgram::Param{
+                     static_cast<std::uint32_t>(p.type), string(p.name), -1});
+            value = methods.size() - 1;
+            break;
+         }
+         case NodeKind::NAME:
+            value = string(SymbolTable::global().getIdentifier(value));
+            break;
+         default:
+            break;
+      }
+      values.push_back(value);
+      ends.push_back(tree.getEnd(node));
+      kinds.push_back(static_cast<std::uint8_t>(tree.getKind(node)));
+   }
+   nameLists.push_back(nameIds.size());
+
+   std::memset(&m_header, 0, sizeof m_header);
+   std::memcpy(m_header.magic, MAGIC, sizeof MAGIC);
+   m_header.version = MappedProgram::VERSION;
+   if (tester) {
+      m_header.hasTester = 1;
+      m_header.testerStrings[0] = string(tester->getPackageName());
+      m_header.testerStrings[1] = string(tester->getClassName());
+      m_header.testerStrings[2] = string(tester->getMethodName());
+      m_header.testerStrings[3] = string(tester->getName());
+      m_header.arity = tester->getAsserts().getArity();
+      m_header.numberAsserts = tester->getAsserts().size();
+   }
+   m_strings.push_back(m_chars.size());
+   m_header.numberNodes = tree.size();
+   m_header.numberNameLists = nameLists.size() - 1;
+   m_header.numberNameIds = nameIds.size();
+   m_header.numberMethods = methods.size();
+   m_header.numberParams = params.size();
+   m_header.numberStrings = m_strings.size() - 1;
+   m_header.numberChars = m_chars.size();
+
+   append(&m_header, 1);
+   append(values);
+   append(ends);
+   append(nameLists);
+   append(nameIds);
+   append(methods);
+   append(params);
+   if (tester) {
+      const AssertBlock& asserts = tester->getAsserts();
+      for (unsigned i=0; i<asserts.size(); ++i)
+         append(asserts.getArgs(i), asserts.getArity());
+      for (unsigned i=0; i<asserts.size(); ++i) {
+         std::int32_t result{asserts.getResult(i)};
+         append(&result, 1);
+      }
+   }
+   append(m_strings);
+   append(m_chars);
+   append(kinds);
+}
+
+//------------------------------------------------------------------------------------
+
+std::uint32_t ProgramFileWriter::string(const std::string& s)
+{
+   auto found = m_stringIds.find(s);
+   if (found != m_stringIds.end()) return found->second;
+   std::uint32_t id{static_cast<std::uint32_t>(m_strings.size())};
+   m_stringIds.emplace(s, id);
+   m_strings.push_back(m_chars.size());
+   m_chars.insert(m_chars.end(), s.begin(), s.end());
+   m_chars.push_back('\0');
+   return id;
+}
+
+//------------------------------------------------------------------------------------
+
+void ProgramFileWriter::write(const boost::filesystem::path& path) const
+{
+   std::ofstream outFileStream{path.c_str(), std::ios::binary};
+   if (!outFileStream) throw BadPath{};
+   outFileStream.write(m_file.data(), m_file.size());
+   if (!outFileStream) throw BadPath{};
+}
+
+//------------------------------------------------------------------------------------
+
+void writeProgramFile(const boost::filesystem::path& path, Boilerplate* program,
+      TesterBoilerplate* tester)
+{
+   ProgramFileWriter{program, tester}.write(path);
+}
+
+//------------------------------------------------------------------------------------
+
+void setProgramFileDirectory(const boost::filesystem::path& directory)
+{
+   programFileDirectory = directory;
+}
+
+//------------------------------------------------------------------------------------
+
+void keepProgramFile(const boost::filesystem::path& studentPath, 
+      const std::string& className, Boilerplate* program, 
+      TesterBoilerplate* tester)
+{
+   namespace bfs = boost::filesystem;
+   if (programFileDirectory.empty()) return;
+   bfs::path directory{programFileDirectory / studentPath};
+   bfs::create_directories(directory);
+   writeProgramFile(directory / (className + ".ast"), program, tester);
+}
+
+//------------------------------------------------------------------------------------
+
+MappedProgram::MappedProgram(const boost::filesystem::path& path)
+{
+   int fd{open(path.c_str(), O_RDONLY)};
+   if (fd == -1) throw BadPath{};
+   struct stat status;
+   if (fstat(fd, &status) == -1 || status.st_size == 0) {
+      close(fd);
+      throw BadPath{};
+   }
+   m_length = status.st_size;
+   // A private mapping, so that fixUp() writes to copies of the pages it changes
+   // rather than to the file
+   m_mapping = mmap(nullptr, m_length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (m_mapping == MAP_FAILED) {
+      m_mapping = nullptr;
+      throw BadPath{};
+   }
+   try {
+      if (m_length < sizeof(Header)) throw BadSize{};
+      m_header = static_cast<const Header*>(m_mapping);
+      if (std::memcmp(m_header->magic, MAGIC, sizeof MAGIC) != 0 ||
+            m_header->version != VERSION)
+         throw BadArgument{};
+
+      // The sections, in 64 bits so that no count in the header can wrap around
+      const Header& h = *m_header;
+      std::uint64_t words[]{h.numberNodes, h.numberNodes, h.numberNameLists + 1ull,
+         h.numberNameIds, h.numberMethods * 4ull, h.numberParams * 3ull,
+         h.numberAsserts * static_cast<std::uint64_t>(h.arity), h.numberAsserts,
+         h.numberStrings + 1ull};
+      std::vector<char*> sections;
+      std::uint64_t offset{sizeof(Header)};
+      for (std::uint64_t number : words) {
+         sections.push_back(static_cast<char*>(m_mapping) + offset);
+         offset += number * 4;
+         if (offset > m_length) throw BadSize{};
+      }
+      if (offset + h.numberChars + h.numberNodes != m_length) throw BadSize{};
+      m_values = reinterpret_cast<std::int32_t*>(sections.at(0));
+      m_ends = reinterpret_cast<const std::uint32_t*>(sections.at(1));
+      m_nameLists = reinterpret_cast<const std::uint32_t*>(sections.at(2));
+      m_nameIds = reinterpret_cast<const std::uint32_t*>(sections.at(3));
+      m_methods = reinterpret_cast<const Method*>(sections.at(4));
+      m_params = reinterpret_cast<Param*>(sections.at(5));
+      m_assertArgs = reinterpret_cast<const std::int32_t*>(sections.at(6));
+      m_assertResults = reinterpret_cast<const std::int32_t*>(sections.at(7));
+      m_strings = reinterpret_cast<const std::uint32_t*>(sections.at(8));
+      m_chars = static_cast<const char*>(m_mapping) + offset;
+      m_kinds = reinterpret_cast<const std::uint8_t*>(m_chars + h.numberChars);
+
+      check();
+      fixUp();
+   }
+   catch (...) {
+      munmap(m_mapping, m_length);
+      throw;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+MappedProgram::~MappedProgram()
+{
+   if (m_mapping) munmap(m_mapping, m_length);
+}
+
+//------------------------------------------------------------------------------------
+
+// Everything that is looked up by index is checked once, here, so that the
+// accessors only have to check node indexes
+void MappedProgram::check() const
+{
+   const Header& h = *m_header;
+   if (m_strings[0] != 0 || m_strings[h.numberStrings] != h.numberChars)
+      throw BadSize{};
+   for (std::uint32_t i=0; i<h.numberStrings; ++i)
+      if (m_strings[i] >= m_strings[i + 1] || m_chars[m_strings[i + 1] - 1] != '\0')
+         throw BadSize{};
+   if (h.hasTester)
+      for (std::uint32_t s : h.testerStrings)
+         if (s >= h.numberStrings) throw BadSize{};
+
+   if (m_nameLists[0] != 0 || m_nameLists[h.numberNameLists] != h.numberNameIds)
+      throw BadSize{};
+   for (std::uint32_t i=0; i<h.numberNameLists; ++i)
+      if (m_nameLists[i] > m_nameLists[i + 1]) throw BadSize{};
+   for (std::uint32_t i=0; i<h.numberNameIds; ++i)
+      if (m_nameIds[i] >= h.numberStrings) throw BadSize{};
+   for (std::uint32_t i=0; i<h.numberMethods; ++i)
+      if (m_methods[i].name >= h.numberStrings ||
+            m_methods[i].numberParams > h.numberParams ||
+            m_methods[i].firstParam > h.numberParams - m_methods[i].numberParams)
+         throw BadSize{};
+   for (std::uint32_t i=0; i<h.numberParams; ++i)
+      if (m_params[i].name >= h.numberStrings) throw BadSize{};
+
+   // Every subtree has to end inside the subtree of its parent
+   std::vector<std::uint32_t> ends{h.numberNodes};
+   for (std::uint32_t node=0; node<h.numberNodes; ++node) {
+      while (ends.back() <= node) ends.pop_back();
+      if (m_ends[node] <= node || m_ends[node] > ends.back()) throw BadSize{};
+      ends.push_back(m_ends[node]);
+      std::uint32_t value{static_cast<std::uint32_t>(m_values[node])};
+      switch (static_cast<NodeKind>(m_kinds[node])) {
+         case NodeKind::BOILERPLATE:
+            if (value >= h.numberNameLists) throw BadSize{};
+            break;
+         case NodeKind::METHOD_DECLARATION:
+            if (value >= h.numberMethods) throw BadSize{};
+            break;
+         case NodeKind::NAME:
+            if (value >= h.numberStrings) throw BadSize{};
+            break;
+         case NodeKind::TESTER_BOILERPLATE:
+         case NodeKind::ASSERT_STATEMENT:
+            throw BadArgument{};
+         default:
+            if (static_cast<NodeKind>(m_kinds[node]) > NodeKind::VAR_DECL_FRAGMENT)
+               throw BadArgument{};
+      }
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void MappedProgram::fixUp()
+{
+   const Header& h = *m_header;
+   std::vector<int> slots(h.numberStrings, -1);
+   for (std::uint32_t node=0; node<h.numberNodes; ++node) {
+      if (static_cast<NodeKind>(m_kinds[node]) != NodeKind::NAME) continue;
+      int& slot = slots.at(m_values[node]);
+      if (slot == -1) slot = SymbolTable::global().intern(getString(m_values[node]));
+      m_values[node] = slot;
+   }
+   // As in FlatTree, a parameter that no name uses has no slot
+   for (std::uint32_t i=0; i<h.numberParams; ++i)
+      m_params[i].slot = SymbolTable::global().find(getString(m_params[i].name));
+}
+
+//------------------------------------------------------------------------------------
+
+std::uint32_t MappedProgram::checked(std::uint32_t node) const
+{
+   if (node >= size()) throw BadSize{};
+   return node;
+}
+
+//------------------------------------------------------------------------------------
+
+unsigned MappedProgram::numberChildren(std::uint32_t node) const
+{
+   unsigned count{0};
+   for (std::uint32_t child=node+1; child<getEnd(node); child=getEnd(child))
+      ++count;
+   return count;
+}
+
+//------------------------------------------------------------------------------------
+
+std::vector<std::string> MappedProgram::getNames(int i) const
+{
+   if (i < 0 || static_cast<std::uint32_t>(i) >= m_header->numberNameLists)
+      throw BadSize{};
+   std::vector<std::string> names;
+   for (std::uint32_t id=m_nameLists[i]; id<m_nameLists[i + 1]; ++id)
+      names.push_back(getString(m_nameIds[id]));
+   return names;
+}
+
+//------------------------------------------------------------------------------------
+
+FlatTree::Method MappedProgram::getMethod(int i) const
+{
+   if (i < 0 || static_cast<std::uint32_t>(i) >= m_header->numberMethods)
+      throw BadSize{};
+   const Method& method = m_methods[i];
+   std::vector<Parameter> params;
+   for (std::uint32_t p=0; p<method.numberParams; ++p) {
+      const Param& param = m_params[method.firstParam + p];
+      params.push_back(Parameter{static_cast<Type>(param.type),
+            getString(param.name)});
+   }
+   return FlatTree::Method{getString(method.name), params,
+      static_cast<Type>(method.returnType)};
+}
+
+//------------------------------------------------------------------------------------
+
+unsigned MappedProgram::numberParams(int method) const
+{
+   if (method < 0 || static_cast<std::uint32_t>(method) >= m_header->numberMethods)
+      throw BadSize{};
+   return m_methods[method].numberParams;
+}
+
+//------------------------------------------------------------------------------------
+
+int MappedProgram::getParamSlot(int method, unsigned i) const
+{
+   if (i >= numberParams(method)) throw BadSize{};
+   return m_params[m_methods[method].firstParam + i].slot;
+}
+
+//------------------------------------------------------------------------------------
+
+const char* MappedProgram::getString(std::uint32_t i) const
+{
+   if (i >= m_header->numberStrings) throw BadSize{};
+   return m_chars + m_strings[i];
+}
+
+//------------------------------------------------------------------------------------
+
+TesterBoilerplate* MappedProgram::toTester() const
+{
+   const Header& h = *m_header;
+   if (!h.hasTester) return nullptr;
+   TesterBoilerplate* tester{new TesterBoilerplate{getString(h.testerStrings[0]),
+      getString(h.testerStrings[1]), getString(h.testerStrings[2]),
+      getString(h.testerStrings[3]), h.arity}};
+   AssertBlock& asserts = tester->getAsserts();
+   asserts.reserve(h.numberAsserts);
+   for (std::uint32_t i=0; i<h.numberAsserts; ++i)
+      asserts.add(m_assertArgs + i * h.arity, m_assertResults[i]);
+   return tester;
+}
@@ -0,0 +1,370 @@
+#include "AST.h"
+
+static long long checkedAdd(long long a, long long b)
+{
+   long long sum;
+   if (__builtin_add_overflow(a, b, &sum)) throw BadSize{};
+   return sum;
+}
+
+//------------------------------------------------------------------------------------
+
+static long long checkedMultiply(long long a, long long b)
+{
+   long long product;
+   if (__builtin_mul_overflow(a, b, &product)) throw BadSize{};
+   return product;
+}
+
+//------------------------------------------------------------------------------------
+
+using Matrix = std::vector<std::vector<long long>>;
+
+static Matrix multiply(const Matrix& a, const Matrix& b)
+{
+   Matrix product(a.size(), std::vector<long long>(b.front().size()));
+   for (unsigned i=0; i<a.size(); ++i)
+      for (unsigned k=0; k<b.size(); ++k)
+         if (a[i][k] != 0)
+            for (unsigned j=0; j<b[k].size(); ++j)
+               product[i][j] = checkedAdd(product[i][j],
+                     checkedMultiply(a[i][k], b[k][j]));
+   return product;
+}
+
+//------------------------------------------------------------------------------------
+
+long long RecurrenceEvaluator::evaluate(Boilerplate* program,
+      const std::vector<long long>& args)
+{
+   m_args = &args;
+   m_vars.assign(SymbolTable::global().size(), 0);
+   m_declared.assign(SymbolTable::global().size(), false);
+   m_returned = false;
+
+   program->accept(this);
+
+   // As with BytecodeVM, the method has to reach a return statement
+   if (!m_returned) throw BadArgument{};
+   return m_result;
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(Boilerplate* boilerplate)
+{
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      d->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(MethodDeclaration* methodDeclaration)
+{
+   const std::vector<Parameter>& params = methodDeclaration->getParamList();
+   if (params.size() != m_args->size()) throw BadSize{};
+   for (unsigned i=0; i<params.size(); ++i)
+      declare(SymbolTable::global().intern(params.at(i).name), m_args->at(i));
+   methodDeclaration->getBody()->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(VarDeclStatement* varDeclStatement)
+{
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      vdf->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(Block* block)
+{
+   for (Statement* s : block->getStatements()) {
+      if (m_returned) return;
+      s->accept(this);
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(ReturnStatement* returnStatement)
+{
+   returnStatement->getExpression()->accept(this);
+   m_result = m_res;
+   m_returned = true;
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(AssignmentStatement* assignmentStatement)
+{
+   long long& assignTo = variable(assignmentStatement->getName()->getSlot());
+   assignmentStatement->getExpression()->accept(this);
+   assignTo = m_res;
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(IfStatement* ifStatement)
+{
+   ifStatement->getExpression()->accept(this);
+   if (m_res)
+      ifStatement->getThenStatement()->accept(this);
+   else if (ifStatement->getElseStatement())
+      ifStatement->getElseStatement()->accept(this);
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(ForStatement* forStatement)
+{
+   for (Expression* e : forStatement->getInitializers())
+      e->accept(this);
+   if (runLinearLoop(forStatement)) return;
+
+   forStatement->getExpression()->accept(this);
+   while (m_res && !m_returned) {
+      forStatement->getBody()->accept(this);
+      if (m_returned) return;
+      for (Expression* e : forStatement->getUpdaters())
+         e->accept(this);
+      forStatement->getExpression()->accept(this);
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(Name* name)
+{
+   m_res = variable(name->getSlot());
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(BooleanLiteral* booleanLiteral)
+{
+   m_res = booleanLiteral->booleanValue();
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(NumberLiteral* numberLiteral)
+{
+   m_res = numberLiteral->getValue();
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(InfixExpression* infixExpression)
+{
+   infixExpression->getLeftOperand()->accept(this);
+   long long left{m_res};
+   infixExpression->getRightOperand()->accept(this);
+   switch (infixExpression->getOperator()) {
+      case InfixOperator::LESS_EQUALS:
+         m_res = left <= m_res;
+         break;
+      case InfixOperator::EQUALS:
+         m_res = left == m_res;
+         break;
+      case InfixOperator::PLUS:
+         m_res = checkedAdd(left, m_res);
+         break;
+      case InfixOperator::TIMES:
+         m_res = checkedMultiply(left, m_res);
+         break;
+      default:
+         throw BadArgument{};
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(PostfixExpression* postfixExpression)
+{
+   // Only variable++ or variable-- is supported
+   Name* name{dynamic_cast<Name*>(postfixExpression->getLeftOperand())};
+   if (!name) throw BadArgument{};
+   long long& operand = variable(name->getSlot());
+   switch (postfixExpression->getOperator()) {
+      case PostfixOperator::INCREMENT:
+         operand = checkedAdd(operand, 1);
+         break;
+      case PostfixOperator::DECREMENT:
+         operand = checkedAdd(operand, -1);
+         break;
+      default:
+         throw BadArgument{};
+   }
+   m_res = operand;
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::visit(VarDeclFragment* varDeclFragment)
+{
+   varDeclFragment->getRightOperand()->accept(this);
+   declare(varDeclFragment->getLeftOperand()->getSlot(), m_res);
+}
+
+//------------------------------------------------------------------------------------
+
+// Runs the (already initialized) loop in closed form if it has the shape
+// described in AST.h, and returns false without changing anything otherwise.
+bool RecurrenceEvaluator::runLinearLoop(ForStatement* forStatement)
+{
+   // for (int i = start; i <= bound; i++)
+   if (forStatement->getInitializers().size() != 1) return false;
+   int counter{forStatement->getInitializers().front()->getLeftOperand()->getSlot()};
+
+   if (forStatement->getUpdaters().size() != 1) return false;
+   PostfixExpression* update{
+      dynamic_cast<PostfixExpression*>(forStatement->getUpdaters().front())};
+   if (!update || update->getOperator() != PostfixOperator::INCREMENT) return false;
+   Name* updated{dynamic_cast<Name*>(update->getLeftOperand())};
+   if (!updated || updated->getSlot() != counter) return false;
+
+   InfixExpression* condition{
+      dynamic_cast<InfixExpression*>(forStatement->getExpression())};
+   if (!condition || condition->getOperator() != InfixOperator::LESS_EQUALS)
+      return false;
+   Name* compared{dynamic_cast<Name*>(condition->getLeftOperand())};
+   if (!compared || compared->getSlot() != counter) return false;
+
+   // The body must be assignments, none of them to the loop counter
+   std::vector<AssignmentStatement*> assignments;
+   Block* body{dynamic_cast<Block*>(forStatement->getBody())};
+   if (!body) return false;
+   for (Statement* s : body->getStatements()) {
+      AssignmentStatement* a{dynamic_cast<AssignmentStatement*>(s)};
+      if (!a || a->getName()->getSlot() == counter) return false;
+      assignments.push_back(a);
+   }
+
+   // The variables assigned in the loop make up its state
+   std::vector<int> state;
+   for (AssignmentStatement* a : assignments)
+      if (std::find(state.begin(), state.end(), a->getName()->getSlot()) ==
+            state.end())
+         state.push_back(a->getName()->getSlot());
+   const unsigned d = state.size();
+
+   // The counter can't appear in a linear form, and the bound mustn't depend on
+   // the state, so the bound is constant during the loop.
+   std::vector<LinearForm> values(d, LinearForm(d + 1));
+   for (unsigned i=0; i<d; ++i) values[i][i] = 1;
+   LinearForm boundForm;
+   if (!toLinearForm(condition->getRightOperand(), counter, state, values, 
+            boundForm))
+      return false;
+   for (unsigned i=0; i<d; ++i) if (boundForm[i] != 0) return false;
+
+   // One pass through the body, in terms of the state at its start
+   std::vector<LinearForm> next(values);
+   for (AssignmentStatement* a : assignments) {
+      LinearForm form;
+      if (!toLinearForm(a->getExpression(), counter, state, next, form)) 
+         return false;
+      next[std::find(state.begin(), state.end(), a->getName()->getSlot()) -
+         state.begin()] = form;
+   }
+
+   long long& counterValue = variable(counter);
+   long long bound{boundForm[d]};
+   if (bound < counterValue) return true; // the body never runs
+   unsigned long long iterations{static_cast<unsigned long long>(bound) -
+      static_cast<unsigned long long>(counterValue) + 1};
+
+   // (state, 1) after the loop is M^iterations (state, 1), with M's rows being
+   // the linear forms of one pass.
+   Matrix power(d + 1, std::vector<long long>(d + 1));
+   for (unsigned r=0; r<d; ++r) power[r] = next[r];
+   power[d][d] = 1;
+   Matrix vector(d + 1, std::vector<long long>(1));
+   for (unsigned r=0; r<d; ++r) vector[r][0] = variable(state[r]);
+   vector[d][0] = 1;
+   for (unsigned long long k=iterations; k; k >>= 1) {
+      if (k & 1) vector = multiply(power, vector);
+      if (k > 1) power = multiply(power, power);
+   }
+
+   for (unsigned r=0; r<d; ++r) variable(state[r]) = vector[r][0];
+   counterValue = checkedAdd(bound, 1);
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+
+// Writes the value of expression as a linear form in the state variables, given
+// their current values as linear forms. Returns false if it isn't linear.
+bool RecurrenceEvaluator::toLinearForm(Expression* expression, int counter,
+      const std::vector<int>& state, const std::vector<LinearForm>& values,
+      LinearForm& form)
+{
+   const unsigned d = state.size();
+   if (Name* name = dynamic_cast<Name*>(expression)) {
+      if (name->getSlot() == counter) return false;
+      auto result = std::find(state.begin(), state.end(), name->getSlot());
+      if (result != state.end()) form = values.at(result - state.begin());
+      else {
+         // Constant during the loop, so its current value will do
+         form.assign(d + 1, 0);
+         form[d] = variable(name->getSlot());
+      }
+      return true;
+   }
+   if (NumberLiteral* number = dynamic_cast<NumberLiteral*>(expression)) {
+      form.assign(d + 1, 0);
+      form[d] = number->getValue();
+      return true;
+   }
+   InfixExpression* infix{dynamic_cast<InfixExpression*>(expression)};
+   if (!infix) return false;
+   LinearForm left, right;
+   if (!toLinearForm(infix->getLeftOperand(), counter, state, values, left) ||
+         !toLinearForm(infix->getRightOperand(), counter, state, values, right))
+      return false;
+   form.assign(d + 1, 0);
+   switch (infix->getOperator()) {
+      case InfixOperator::PLUS:
+         for (unsigned i=0; i<=d; ++i) form[i] = checkedAdd(left[i], right[i]);
+         return true;
+      case InfixOperator::TIMES: {
+         // One side has to be a constant for the product to stay linear
+         bool leftConstant{std::all_of(left.begin(), left.end() - 1, 
+               [](long long c) { return c == 0; })};
+         bool rightConstant{std::all_of(right.begin(), right.end() - 1, 
+               [](long long c) { return c == 0; })};
+         if (!leftConstant && !rightConstant) return false;
+         long long factor{leftConstant ? left[d] : right[d]};
+         const LinearForm& other = leftConstant ? right : left;
+         for (unsigned i=0; i<=d; ++i) form[i] = checkedMultiply(factor, other[i]);
+         return true;
+      }
+      default:
+         return false;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+long long& RecurrenceEvaluator::variable(int slot)
+{
+   if (slot >= static_cast<int>(m_declared.size()) || !m_declared[slot])
+      throw BadArgument{};
+   return m_vars[slot];
+}
+
+//------------------------------------------------------------------------------------
+
+void RecurrenceEvaluator::declare(int slot, long long value)
+{
+   if (slot >= static_cast<int>(m_declared.size())) {
+      m_vars.resize(slot + 1);
+      m_declared.resize(slot + 1);
+   }
+   if (m_declared[slot]) throw BadArgument{};
+   m_declared[slot] = true;
+   m_vars[slot] = value;
+}
@@ -1,16 +1,49 @@
 #include "AST.h"
 
+ResultFinder::ResultFinder(const std::vector<int>& inputs, 
+      const std::vector<std::string> inputNames)
+   :m_in(SymbolTable::global().size()), m_declared(SymbolTable::global().size())
+{
+   if (inputs.size() != inputNames.size()) throw BadSize{};
+   for (unsigned i=0; i<inputs.size(); ++i)
+      addInput(inputNames.at(i), inputs.at(i));
+}
+
+//------------------------------------------------------------------------------------
+
+void ResultFinder::addInput(const std::string& s, const int i)
+{
+   declare(SymbolTable::global().intern(s), i);
+}
+
+//------------------------------------------------------------------------------------
+
+void ResultFinder::declare(int slot, int value)
+{
+   if (isDeclared(slot)) throw BadArgument{};
+   // Only needed for Names created after this ResultFinder
+   if (slot >= static_cast<int>(m_in.size())) {
+      m_in.resize(slot + 1);
+      m_declared.resize(slot + 1);
+   }
+   m_declared[slot] = true;
+   m_in[slot] = value;
+   m_scope.push_back(slot);
+}
+
+//------------------------------------------------------------------------------------
+
 void ResultFinder::visit(Boilerplate* boilerplate)
 {
    for (Declaration* d : boilerplate->getBodyDeclarations())
-      d->accept(this);
+      dispatch(d, *this);
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(MethodDeclaration* methodDeclaration)
 {
-   methodDeclaration->getBody()->accept(this);
+   dispatch(methodDeclaration->getBody(), *this);
 }
 
 //------------------------------------------------------------------------------------
@@ -18,52 +51,50 @@ void ResultFinder::visit(MethodDeclaration* methodDeclaration)
 void ResultFinder::visit(VarDeclStatement* varDeclStatement)
 {
    for (VarDeclFragment* vdf : varDeclStatement->getFragments())
-      vdf->accept(this);
+      dispatch(vdf, *this);
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(Block* block)
 {
+   std::size_t scope{m_scope.size()};
    for (Statement* s : block->getStatements())
-      s->accept(this);
+      dispatch(s, *this);
+   for (; m_scope.size() > scope; m_scope.pop_back())
+      m_declared[m_scope.back()] = false;
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(ReturnStatement* returnStatement)
 {
-   returnStatement->getExpression()->accept(this);
-   m_res = std::to_string(m_compareVal);
+   dispatch(returnStatement->getExpression(), *this);
+   m_res = m_compareVal;
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(AssignmentStatement* assignmentStatement)
 {
-   assignmentStatement->getName()->accept(this);
    // Check that we're assigning to a variable already in the symbol table:
-   auto result = std::find(m_inNames.begin(), m_inNames.end(), m_compareName);
-   if (result == m_inNames.end()) throw BadArgument{};
+   int assignTo{assignmentStatement->getName()->getSlot()};
+   if (!isDeclared(assignTo)) throw BadArgument{};
 
-   // Save the to-be-assigned-to name
-   std::string assignTo{m_compareName};
    // Evaluate the right-hand expression:
-   assignmentStatement->getExpression()->accept(this);
-   for (unsigned i=0; i<m_inNames.size(); ++i)
-      if (m_inNames.at(i) == assignTo)
-         m_in.at(i) = m_compareVal;
+   dispatch(assignmentStatement->getExpression(), *this);
+   m_in[assignTo] = m_compareVal;
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(IfStatement* ifStatement)
 {
-   ifStatement->getExpression()->accept(this);
+   dispatch(ifStatement->getExpression(), *this);
    if (m_compare)
-      ifStatement->getThenStatement()->accept(this);
+      dispatch(ifStatement->getThenStatement(), *this);
    else if (ifStatement->getElseStatement())
-      ifStatement->getElseStatement()->accept(this);
+      dispatch(ifStatement->getElseStatement(), *this);
 }
 
 //------------------------------------------------------------------------------------
@@ -71,13 +102,13 @@ void ResultFinder::visit(IfStatement* ifStatement)
 void ResultFinder::visit(ForStatement* forStatement)
 {
    for (Expression* e : forStatement->getInitializers())
-      e->accept(this);
-   forStatement->getExpression()->accept(this);
+      dispatch(e, *this);
+   dispatch(forStatement->getExpression(), *this);
    while (m_compare) {
-      forStatement->getBody()->accept(this);
+      dispatch(forStatement->getBody(), *this);
       for (Expression* e : forStatement->getUpdaters())
-         e->accept(this);
-      forStatement->getExpression()->accept(this);
+         dispatch(e, *this);
+      dispatch(forStatement->getExpression(), *this);
    }
 }
 
@@ -85,13 +116,8 @@ void ResultFinder::visit(ForStatement* forStatement)
 
 void ResultFinder::visit(Name* name)
 {
-   m_compareName = name->getName();
-   auto result = std::find(m_inNames.begin(), m_inNames.end(), m_compareName); 
-   if (result != m_inNames.end()) {
-      for (unsigned i=0; i<m_inNames.size(); ++i)
-         if (m_inNames.at(i) == m_compareName)
-            m_compareVal = m_in.at(i);
-   }
+   m_compareSlot = name->getSlot();
+   if (isDeclared(m_compareSlot)) m_compareVal = m_in[m_compareSlot];
 }
    
 //------------------------------------------------------------------------------------
@@ -105,8 +131,7 @@ void ResultFinder::visit(BooleanLiteral* booleanLiteral)
 
 void ResultFinder::visit(NumberLiteral* numberLiteral)
 {
-   m_compareVal = std::stoi(numberLiteral->getToken());
-   m_res = numberLiteral->getToken();
+   m_compareVal = numberLiteral->getValue();
 }
 
 //------------------------------------------------------------------------------------
@@ -115,11 +140,11 @@ void ResultFinder::visit(InfixExpression* infixExpression)
 {
    // Sets m_compareVal to the result of evaluating the InfixExpression (if it's
    // an integer expression), or m_compare to the result if it's a boolean expression
-   infixExpression->getLeftOperand()->accept(this);
+   dispatch(infixExpression->getLeftOperand(), *this);
    m_op = infixExpression->getOperator();
    int tempVal{m_compareVal};
    InfixOperator tempOp{m_op};
-   infixExpression->getRightOperand()->accept(this);
+   dispatch(infixExpression->getRightOperand(), *this);
    switch (tempOp) {
       case InfixOperator::LESS_EQUALS:
          if (tempVal <= m_compareVal) m_compare = true;
@@ -145,30 +170,27 @@ void ResultFinder::visit(InfixExpression* infixExpression)
 void ResultFinder::visit(PostfixExpression* postfixExpression)
 {
    // A bit of a hack: only works with variable++ or variable--
-   postfixExpression->getLeftOperand()->accept(this);
-   for (unsigned i=0; i<m_inNames.size(); ++i)
-      if (m_inNames.at(i) == m_compareName)
-         switch(postfixExpression->getOperator()) {
-            case PostfixOperator::INCREMENT:
-               m_in.at(i) = ++m_compareVal;
-               break;
-            case PostfixOperator::DECREMENT:
-               m_in.at(i) = --m_compareVal;
-               break;
-            default:
-               throw BadArgument{};
-               break;
-         }
+   dispatch(postfixExpression->getLeftOperand(), *this);
+   if (isDeclared(m_compareSlot))
+      switch(postfixExpression->getOperator()) {
+         case PostfixOperator::INCREMENT:
+            m_in[m_compareSlot] = ++m_compareVal;
+            break;
+         case PostfixOperator::DECREMENT:
+            m_in[m_compareSlot] = --m_compareVal;
+            break;
+         default:
+            throw BadArgument{};
+            break;
+      }
 }
 
 //------------------------------------------------------------------------------------
 
 void ResultFinder::visit(VarDeclFragment* varDeclFragment)
 {
-   varDeclFragment->getLeftOperand()->accept(this);
-   auto result = std::find(m_inNames.begin(), m_inNames.end(), m_compareName);
-   if (result != m_inNames.end()) throw BadArgument{};
-   m_inNames.push_back(m_compareName);
-   varDeclFragment->getRightOperand()->accept(this);
-   m_in.push_back(m_compareVal);
+   int slot{varDeclFragment->getLeftOperand()->getSlot()};
+   if (isDeclared(slot)) throw BadArgument{};
+   dispatch(varDeclFragment->getRightOperand(), *this);
+   declare(slot, m_compareVal);
 }
@@ -2,18 +2,19 @@
 
 void SchemePrinter::visit(TesterBoilerplate* tester)
 {
-   *m_os << "(include \"assert.scm\")" << std::endl;
-   *m_os << "(include \"" << tester->getPackageName() << '/' << tester->getClassName()
-     << ".scm\")" << std::endl;
+   *m_out << "(include \"assert.scm\")" << '\n';
+   *m_out << "(include \"" << tester->getPackageName() << '/' << tester->getClassName()
+     << ".scm\")" << '\n';
    setIndents(0);
-   *m_os << "(and" << std::endl;
+   *m_out << "(and" << '\n';
    incrementIndents();
-   for (AssertStatement* as : tester->getAsserts()) {
+   for (unsigned i=0; i<tester->getAsserts().size(); ++i) {
       printIndents();
-      as->accept(this);
+      AssertStatement as{tester->getAsserts(), i};
+      as.accept(this);
    }
    printIndents();
-   *m_os << "(print \"Tests passed!\\n\"))" << std::endl;
+   *m_out << "(print \"Tests passed!\\n\"))" << '\n';
    decrementIndents();
 }
 
@@ -31,20 +32,20 @@ void SchemePrinter::visit(Boilerplate* boilerplate)
 void SchemePrinter::visit(MethodDeclaration* methodDeclaration)
 {
    printIndents();
-   *m_os << "(define (" << methodDeclaration->getName() << ' ';
+   *m_out << "(define (" << methodDeclaration->getName() << ' ';
    if (methodDeclaration->getParamList().size() > 0) {
       for (unsigned i=0; i<methodDeclaration->getParamList().size()-1; ++i) {
          const Parameter& p = methodDeclaration->getParamList().at(i);
-         *m_os << p.name << ' ';
+         *m_out << p.name << ' ';
       }
       const Parameter& p = methodDeclaration->getParamList().back();
-      *m_os << p.name;
+      *m_out << p.name;
    }
-   *m_os << ')' << std::endl;
+   *m_out << ')' << '\n';
    incrementIndents();
 
    methodDeclaration->getBody()->accept(this);
-   *m_os << ')' << std::endl;
+   *m_out << ')' << '\n';
    decrementIndents();
 }
 
@@ -52,46 +53,57 @@ void SchemePrinter::visit(MethodDeclaration* methodDeclaration)
 
 void SchemePrinter::visit(VarDeclStatement* varDeclStatement)
 {
-   // Note: unbalanced bracket. This must be balanced by the function block.
+   // Note: unbalanced bracket. This is balanced at the end of the block.
    printIndents();
-   *m_os << "(let (";
+   *m_out << "(let (";
    for (unsigned i=0; i<varDeclStatement->getFragments().size(); ++i) {
       varDeclStatement->getFragments().at(i)->accept(this);
       if (i != varDeclStatement->getFragments().size() - 1)
-         *m_os << ' ';
+         *m_out << ' ';
    }
-   *m_os << ')' << std::endl;
+   *m_out << ')' << '\n';
    incrementIndents();
+   leaveOpen(1);
 }
 
 //------------------------------------------------------------------------------------
 
 void SchemePrinter::visit(AssertStatement* assert)
 {
-   *m_os << "(assert \"(" << assert->getMethodName() << ' ';
+   const int* args{assert->getArgs()};
+   const unsigned last{assert->getArity() - 1};
+   *m_out << "(assert \"(" << assert->getMethodName() << ' ';
 
-   for (unsigned i=0; i<assert->getParameters().size()-1; ++i)
-      *m_os << assert->getParameters().at(i) << ' ';
-   *m_os << assert->getParameters().back() << ") must be " << assert->getResult()
+   for (unsigned i=0; i<last; ++i)
+      *m_out << args[i] << ' ';
+   *m_out << args[last] << ") must be " << assert->getResult()
       << "\" (= (" << assert->getMethodName() << ' ';
 
-   for (unsigned i=0; i<assert->getParameters().size()-1; ++i)
-      *m_os << assert->getParameters().at(i) << ' ';
-   *m_os << assert->getParameters().back() << ") " << assert->getResult() << "))"
-      << std::endl;
+   for (unsigned i=0; i<last; ++i)
+      *m_out << args[i] << ' ';
+   *m_out << args[last] << ") " << assert->getResult() << "))"
+      << '\n';
 }
 
 //------------------------------------------------------------------------------------
 
 void SchemePrinter::visit(Block* block)
 {
+   m_openBrackets.push_back(0);
    for (Statement* statement : block->getStatements())
       statement->accept(this);
 
-   MissingBracket mb;
-   mb.setOutStream(*m_os);
-   for (Statement* statement : block->getStatements())
-      statement->accept(&mb);
+   for (unsigned i=0; i<m_openBrackets.back(); ++i)
+      *m_out << ')';
+   m_openBrackets.pop_back();
+}
+
+//------------------------------------------------------------------------------------
+
+void SchemePrinter::leaveOpen(unsigned brackets)
+{
+   // Outside a block there's nowhere to close them
+   if (!m_openBrackets.empty()) m_openBrackets.back() += brackets;
 }
 
 //------------------------------------------------------------------------------------
@@ -107,11 +119,11 @@ void SchemePrinter::visit(ReturnStatement* returnStatement)
 void SchemePrinter::visit(AssignmentStatement* assignmentStatement)
 {
    printIndents();
-   *m_os << "(set! ";
+   *m_out << "(set! ";
    assignmentStatement->getName()->accept(this);
-   *m_os << ' ';
+   *m_out << ' ';
    assignmentStatement->getExpression()->accept(this);
-   *m_os << ')' << std::endl;
+   *m_out << ')' << '\n';
 }
 
 //------------------------------------------------------------------------------------
@@ -119,23 +131,24 @@ void SchemePrinter::visit(AssignmentStatement* assignmentStatement)
 void SchemePrinter::visit(IfStatement* ifStatement)
 {
    printIndents();
-   *m_os << "(if ";
+   *m_out << "(if ";
    ifStatement->getExpression()->accept(this);
-   *m_os << std::endl;
+   *m_out << '\n';
    incrementIndents();
    ifStatement->getThenStatement()->accept(this);
 
    if (ifStatement->getElseStatement()) {
-      *m_os << std::endl;
+      *m_out << '\n';
       ifStatement->getElseStatement()->accept(this);
       decrementIndents();
-      *m_os << ')'; 
+      *m_out << ')'; 
    }
    else {
-      *m_os << std::endl;
+      *m_out << '\n';
       printIndents();
-      *m_os << "(begin" << std::endl;
+      *m_out << "(begin" << '\n';
       incrementIndents();
+      leaveOpen(2);
    }
 }
 
@@ -144,26 +157,26 @@ void SchemePrinter::visit(IfStatement* ifStatement)
 void SchemePrinter::visit(ForStatement* forStatement)
 {
    printIndents();
-   *m_os << "(let for";
+   *m_out << "(let for";
    if (!forStatement->getInitializers().empty())
-      *m_os << '(';
+      *m_out << '(';
    for (Expression* e : forStatement->getInitializers()) e->accept(this);
-   *m_os << ')' << std::endl;
+   *m_out << ')' << '\n';
    incrementIndents();
    printIndents();
-   *m_os << "(if ";
+   *m_out << "(if ";
    forStatement->getExpression()->accept(this);
-   *m_os << std::endl;
+   *m_out << '\n';
    incrementIndents();
    printIndents();
-   *m_os << "(begin" <<std::endl;
+   *m_out << "(begin" <<'\n';
    incrementIndents();
    forStatement->getBody()->accept(this);
    printIndents();
-   *m_os << "(for ";
+   *m_out << "(for ";
    for (Expression* e : forStatement->getUpdaters()) e->accept(this);
-   *m_os << "))))";
-   *m_os << std::endl;
+   *m_out << "))))";
+   *m_out << '\n';
    for (int i=0; i<3; ++i) decrementIndents();
 }
 
@@ -172,16 +185,15 @@ void SchemePrinter::visit(ForStatement* forStatement)
 void SchemePrinter::visit(BooleanLiteral* booleanLiteral)
 {
    if (booleanLiteral->booleanValue() == true)
-      *m_os << "#t";
-   else *m_os << "#f";
+      *m_out << "#t";
+   else *m_out << "#f";
 }
 
 //------------------------------------------------------------------------------------
 
 void SchemePrinter::visit(NumberLiteral* numberLiteral)
 {
-   std::string token{numberLiteral->getToken()};
-   *m_os << token;
+   printNumber(numberLiteral);
 }
 
 //------------------------------------------------------------------------------------
@@ -189,30 +201,30 @@ void SchemePrinter::visit(NumberLiteral* numberLiteral)
 // Prefix, rather than infix here :P
 void SchemePrinter::visit(InfixExpression* infixExpression)
 {
-   *m_os << '(';
-   *m_os << infixOpToStringScm(infixExpression->getOperator()) << ' ';
+   *m_out << '(';
+   *m_out << Scheme::infixOp(infixExpression->getOperator()) << ' ';
    infixExpression->getLeftOperand()->accept(this);
-   *m_os << ' ';
+   *m_out << ' ';
    infixExpression->getRightOperand()->accept(this);
-   *m_os << ')';
+   *m_out << ')';
 }
 
 //------------------------------------------------------------------------------------
 
 void SchemePrinter::visit(PostfixExpression* postfixExpression)
 {
-   *m_os << '(' << postfixOpToStringScm(postfixExpression->getOperator()) << ' ';
+   *m_out << '(' << Scheme::postfixOp(postfixExpression->getOperator()) << ' ';
    postfixExpression->getLeftOperand()->accept(this);
-   *m_os << " 1)";
+   *m_out << " 1)";
 }
 
 //------------------------------------------------------------------------------------
 
 void SchemePrinter::visit(VarDeclFragment* varDeclFragment)
 {
-   *m_os << '(';
+   *m_out << '(';
    varDeclFragment->getLeftOperand()->accept(this);
-   *m_os << ' ';
+   *m_out << ' ';
    varDeclFragment->getRightOperand()->accept(this);
-   *m_os << ')';
+   *m_out << ')';
 }
@@ -0,0 +1,228 @@
+#include "AST.h"
+
+std::uint64_t ASTNode::hash()
+{
+   StructuralHasher hasher;
+   accept(&hasher);
+   return hasher.getHash();
+}
+
+//------------------------------------------------------------------------------------
+
+// 64-bit FNV-1a, over the hashed values rather than bytes. Each value is first
+// put through the finalizer of splitmix64, so that all of its bits count.
+void StructuralHasher::start(NodeKind kind)
+{
+   m_hash = 14695981039346656037ull;
+   add(static_cast<std::uint64_t>(kind));
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::add(std::uint64_t value)
+{
+   value ^= value >> 30;
+   value *= 0xbf58476d1ce4e5b9ull;
+   value ^= value >> 27;
+   value *= 0x94d049bb133111ebull;
+   value ^= value >> 31;
+   m_hash ^= value;
+   m_hash *= 1099511628211ull;
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::add(const std::string& s)
+{
+   std::uint64_t h{14695981039346656037ull};
+   for (char c : s) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ull;
+   }
+   // The length keeps e.g. names "ab", "c" apart from "a", "bc"
+   add(s.size());
+   add(h);
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::add(ASTNode* child)
+{
+   // A missing child (an if-statement's else) hashes differently from any node
+   add(child ? child->hash() : 0);
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(TesterBoilerplate* tester)
+{
+   start(NodeKind::TESTER_BOILERPLATE);
+   add(tester->getPackageName());
+   add(tester->getClassName());
+   add(tester->getMethodName());
+   add(tester->getName());
+   const AssertBlock& asserts = tester->getAsserts();
+   add(asserts.getArity());
+   add(asserts.size());
+   for (unsigned i=0; i<asserts.size(); ++i) {
+      for (unsigned j=0; j<asserts.getArity(); ++j)
+         add(static_cast<std::uint64_t>(asserts.getArgs(i)[j]));
+      add(static_cast<std::uint64_t>(asserts.getResult(i)));
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(Boilerplate* boilerplate)
+{
+   start(NodeKind::BOILERPLATE);
+   add(boilerplate->getNames().size());
+   for (const std::string& name : boilerplate->getNames())
+      add(name);
+   add(boilerplate->getBodyDeclarations().size());
+   for (Declaration* d : boilerplate->getBodyDeclarations())
+      add(d);
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(MethodDeclaration* methodDeclaration)
+{
+   start(NodeKind::METHOD_DECLARATION);
+   add(methodDeclaration->getName());
+   add(static_cast<std::uint64_t>(methodDeclaration->getReturnType()));
+   add(methodDeclaration->getParamList().size());
+   for (const Parameter& p : methodDeclaration->getParamList()) {
+      add(static_cast<std::uint64_t>(p.type));
+      add(p.name);
+   }
+   add(methodDeclaration->getBody());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(VarDeclStatement* varDeclStatement)
+{
+   start(NodeKind::VAR_DECL_STATEMENT);
+   add(static_cast<std::uint64_t>(varDeclStatement->getType()));
+   add(varDeclStatement->getFragments().size());
+   for (VarDeclFragment* vdf : varDeclStatement->getFragments())
+      add(vdf);
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(AssertStatement* assert)
+{
+   start(NodeKind::ASSERT_STATEMENT);
+   add(assert->getMethodName());
+   add(assert->getArity());
+   for (unsigned i=0; i<assert->getArity(); ++i)
+      add(static_cast<std::uint64_t>(assert->getArgs()[i]));
+   add(static_cast<std::uint64_t>(assert->getResult()));
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(Block* block)
+{
+   start(NodeKind::BLOCK);
+   add(block->getStatements().size());
+   for (Statement* s : block->getStatements())
+      add(s);
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(ReturnStatement* returnStatement)
+{
+   start(NodeKind::RETURN_STATEMENT);
+   add(returnStatement->getExpression());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(AssignmentStatement* assignmentStatement)
+{
+   start(NodeKind::ASSIGNMENT_STATEMENT);
+   add(assignmentStatement->getName());
+   add(assignmentStatement->getExpression());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(IfStatement* ifStatement)
+{
+   start(NodeKind::IF_STATEMENT);
+   add(ifStatement->getExpression());
+   add(ifStatement->getThenStatement());
+   add(ifStatement->getElseStatement());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(ForStatement* forStatement)
+{
+   start(NodeKind::FOR_STATEMENT);
+   add(forStatement->getInitializers().size());
+   for (VarDeclFragment* vdf : forStatement->getInitializers())
+      add(vdf);
+   add(forStatement->getExpression());
+   add(forStatement->getUpdaters().size());
+   for (Expression* e : forStatement->getUpdaters())
+      add(e);
+   add(forStatement->getBody());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(Name* name)
+{
+   start(NodeKind::NAME);
+   add(name->getName());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(BooleanLiteral* booleanLiteral)
+{
+   start(NodeKind::BOOLEAN_LITERAL);
+   add(booleanLiteral->booleanValue());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(NumberLiteral* numberLiteral)
+{
+   start(NodeKind::NUMBER_LITERAL);
+   add(static_cast<std::uint64_t>(numberLiteral->getValue()));
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(InfixExpression* infixExpression)
+{
+   start(NodeKind::INFIX_EXPRESSION);
+   add(static_cast<std::uint64_t>(infixExpression->getOperator()));
+   add(infixExpression->getLeftOperand());
+   add(infixExpression->getRightOperand());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(PostfixExpression* postfixExpression)
+{
+   start(NodeKind::POSTFIX_EXPRESSION);
+   add(static_cast<std::uint64_t>(postfixExpression->getOperator()));
+   add(postfixExpression->getLeftOperand());
+}
+
+//------------------------------------------------------------------------------------
+
+void StructuralHasher::visit(VarDeclFragment* varDeclFragment)
+{
+   start(NodeKind::VAR_DECL_FRAGMENT);
+   add(static_cast<std::uint64_t>(varDeclFragment->getType()));
+   add(varDeclFragment->getLeftOperand());
+   add(varDeclFragment->getRightOperand());
+}
@@ -0,0 +1,276 @@
+#include "AST.h"
+#include <chrono>
+
+// Benchmarks run by make bench. Each one times an old way of doing something
+// against the way that replaced it, on programs made as the generator makes
+// them, and prints the best of a few runs of each.
+
+static const unsigned REPEATS{5};
+
+//------------------------------------------------------------------------------------
+
+// Best time of REPEATS calls of f, in milliseconds
+template <typename F> static double bestTime(F f)
+{
+   double best{0};
+   for (unsigned r=0; r<REPEATS; ++r) {
+      std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+      f();
+      std::chrono::duration<double, std::milli> time{
+         std::chrono::steady_clock::now() - start};
+      if (r == 0 || time.count() < best) best = time.count();
+   }
+   return best;
+}
+
+//------------------------------------------------------------------------------------
+
+static void report(const std::string& what, double oldTime, double newTime)
+{
+   std::cout << what << ": " << oldTime << " ms before, " << newTime
+      << " ms now (" << oldTime / newTime << " times as fast)" << std::endl;
+}
+
+//------------------------------------------------------------------------------------
+
+// The A1 and A2 programs of a roster of numberStudents, in all four languages
+static void makeCasesPrograms(unsigned numberStudents,
+      std::vector<Boilerplate*>& programs)
+{
+   std::vector<Parameter> params{Parameter{Type::INT, "v"},
+      Parameter{Type::INT, "u"}, Parameter{Type::INT, "w"}};
+   for (unsigned i=0; i < numberStudents * 4 * 2; ++i)
+      programs.push_back(createCasesProgram("se2s03", "A1", params));
+}
+
+//------------------------------------------------------------------------------------
+
+// Working out the tests' results of every program with a new ResultFinder for
+// each test, against compiling each program once and running it in a BytecodeVM
+static void benchBytecode(const std::vector<Boilerplate*>& programs)
+{
+   const unsigned NUMBER_TESTS{205};
+   const std::vector<std::string> params{"v", "u", "w"};
+   Rand_int rnd{-TEST_RANGE, TEST_RANGE};
+   std::vector<std::vector<int>> tests(NUMBER_TESTS);
+   for (std::vector<int>& args : tests)
+      for (unsigned j=0; j<params.size(); ++j) args.push_back(rnd());
+
+   // Summed, so that the results are used, and compared
+   long long finderSum{0}, vmSum{0};
+   double finderTime{bestTime([&] {
+      for (Boilerplate* program : programs)
+         for (const std::vector<int>& args : tests) {
+            ResultFinder finder{args, params};
+            program->accept(&finder);
+            finderSum += finder.getResult();
+         }
+   })};
+   double vmTime{bestTime([&] {
+      BytecodeVM vm;
+      for (Boilerplate* program : programs) {
+         BytecodeCompiler compiler;
+         program->accept(&compiler);
+         for (const std::vector<int>& args : tests)
+            vmSum += vm.run(compiler.getBytecode(), args);
+      }
+   })};
+   report("Results of " + std::to_string(programs.size()) + " A1/A2 programs, "
+         "ResultFinder against BytecodeVM", finderTime, vmTime);
+   if (finderSum != vmSum) std::cerr << "The results differ" << std::endl;
+}
+
+//------------------------------------------------------------------------------------
+
+// Counts the nodes of a tree, reaching each child through dispatch() if
+// byDispatch, and through accept() otherwise
+template <bool byDispatch> struct NodeCounter : ASTVisitor {
+   void visit(TesterBoilerplate* tester) { count(tester); }
+   void visit(Boilerplate* boilerplate) { count(boilerplate); }
+   void visit(MethodDeclaration* methodDeclaration) { count(methodDeclaration); }
+   void visit(VarDeclStatement* varDeclStatement) { count(varDeclStatement); }
+   void visit(AssertStatement* assert) { count(assert); }
+   void visit(Block* block) { count(block); }
+   void visit(ReturnStatement* returnStatement) { count(returnStatement); }
+   void visit(AssignmentStatement* assignmentStatement) 
+   { 
+      count(assignmentStatement); 
+   }
+   void visit(IfStatement* ifStatement) { count(ifStatement); }
+   void visit(ForStatement* forStatement) { count(forStatement); }
+   void visit(Name* name) { count(name); }
+   void visit(BooleanLiteral* booleanLiteral) { count(booleanLiteral); }
+   void visit(NumberLiteral* numberLiteral) { count(numberLiteral); }
+   void visit(InfixExpression* infixExpression) { count(infixExpression); }
+   void visit(PostfixExpression* postfixExpression) { count(postfixExpression); }
+   void visit(VarDeclFragment* varDeclFragment) { count(varDeclFragment); }
+
+   void reach(ASTNode* node) 
+   {
+      if (byDispatch) dispatch(node, *this);
+      else node->accept(this);
+   }
+   template <typename T> void count(T* node)
+   {
+      ++m_nodes;
+      for (unsigned i=0; ASTNode* child = childOf(node, i); ++i)
+         reach(child);
+   }
+
+   unsigned long long m_nodes{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// Walking every program's tree by accept(), two virtual calls per node, against
+// walking it by dispatch(), one indirect call through a table
+static void benchDispatch(const std::vector<Boilerplate*>& programs)
+{
+   const unsigned NUMBER_WALKS{200};
+   NodeCounter<false> byAccept;
+   NodeCounter<true> byDispatch;
+   double acceptTime{bestTime([&] {
+      for (unsigned w=0; w<NUMBER_WALKS; ++w)
+         for (Boilerplate* program : programs) byAccept.reach(program);
+   })};
+   double dispatchTime{bestTime([&] {
+      for (unsigned w=0; w<NUMBER_WALKS; ++w)
+         for (Boilerplate* program : programs) byDispatch.reach(program);
+   })};
+   report("Walks of " + std::to_string(byAccept.m_nodes / REPEATS) + " nodes, "
+         "accept() against dispatch()", acceptTime, dispatchTime);
+}
+
+//------------------------------------------------------------------------------------
+
+// Counts the nodes of a tree with a TreeWalker
+struct WalkCounter : TreeWalker<WalkCounter> {
+   template <typename T> void enter(T* node) { ++m_nodes; }
+
+   unsigned long long m_nodes{0};
+};
+
+//------------------------------------------------------------------------------------
+
+// Walking the programs recursively, against walking them with a TreeWalker; and
+// evaluating them with ResultFinder, which recurses, against EvaluationFrame,
+// which runs on a TreeWalker
+static void benchWalker(const std::vector<Boilerplate*>& programs)
+{
+   const unsigned NUMBER_WALKS{200};
+   NodeCounter<true> recursive;
+   WalkCounter walker;
+   double recursiveTime{bestTime([&] {
+      for (unsigned w=0; w<NUMBER_WALKS; ++w)
+         for (Boilerplate* program : programs) recursive.reach(program);
+   })};
+   double walkerTime{bestTime([&] {
+      for (unsigned w=0; w<NUMBER_WALKS; ++w)
+         for (Boilerplate* program : programs) walker.walk(program);
+   })};
+   report("Walks of " + std::to_string(walker.m_nodes / REPEATS) + " nodes, "
+         "recursive dispatch() against TreeWalker", recursiveTime, walkerTime);
+
+   const std::vector<std::string> params{"v", "u", "w"};
+   std::vector<int> args(params.size());
+   long long finderSum{0}, frameSum{0};
+   double finderTime{bestTime([&] {
+      for (Boilerplate* program : programs)
+         for (int v=-TEST_RANGE; v<=TEST_RANGE; v += 2) {
+            args.at(0) = args.at(1) = args.at(2) = v;
+            ResultFinder finder{args, params};
+            program->accept(&finder);
+            finderSum += finder.getResult();
+         }
+   })};
+   EvaluationFrame frame;
+   double frameTime{bestTime([&] {
+      for (Boilerplate* program : programs)
+         for (int v=-TEST_RANGE; v<=TEST_RANGE; v += 2) {
+            args.at(0) = args.at(1) = args.at(2) = v;
+            frameSum += frame.run(program, args).asInt();
+         }
+   })};
+   report("Results of " + std::to_string(programs.size()) + " A1/A2 programs, "
+         "ResultFinder against EvaluationFrame", finderTime, frameTime);
+   if (finderSum != frameSum) std::cerr << "The results differ" << std::endl;
+}
+
+//------------------------------------------------------------------------------------
+
+// Evaluating return 1 + (1 + (... + n)) with numberInfixes additions, and if
+// (n <= 0) ... if (n <= 0) return n; with numberIfs if-statements in a chain,
+// which recursing visitors can't do without running out of stack
+static void benchDeepTrees(unsigned numberInfixes, unsigned numberIfs)
+{
+   NodeFactory& nodes = NodeFactory::global();
+   std::vector<Parameter> params{Parameter{Type::INT, "n"}};
+   // Deleting a chain would recurse as deep as it is, so the chains are made in
+   // a shared arena: their parents don't delete them, and the arena gives back
+   // their memory
+   NodeArena chains{64 * 1024, true};
+   Expression* sum{nodes.name("n")};
+   Statement* ifs{nullptr};
+   {
+      ArenaScope scope{chains};
+      ifs = new ReturnStatement{nodes.name("n")};
+      for (unsigned i=0; i<numberInfixes; ++i)
+         sum = new InfixExpression{nodes.number(1), InfixOperator::PLUS, sum};
+      for (unsigned i=0; i<numberIfs; ++i)
+         ifs = new IfStatement{nodes.infix(nodes.name("n"),
+               InfixOperator::LESS_EQUALS, nodes.number(0)), ifs};
+   }
+   Block* infixBlock{new Block};
+   infixBlock->addStatement(new ReturnStatement{sum});
+   Boilerplate* infixProgram{createBoilerPlate("se2s03", "Deep", infixBlock, 
+         "sum", params, Type::INT)};
+   Block* ifBlock{new Block};
+   ifBlock->addStatement(ifs);
+   ifBlock->addStatement(new ReturnStatement{nodes.number(1)});
+   Boilerplate* ifProgram{createBoilerPlate("se2s03", "Deep", ifBlock, "ifs", 
+         params, Type::INT)};
+
+   EvaluationFrame frame;
+   int infixResult{0}, ifResult{0};
+   double infixTime{bestTime([&] {
+      infixResult = frame.run(infixProgram, std::vector<int>{0}).asInt();
+   })};
+   double ifTime{bestTime([&] {
+      ifResult = frame.run(ifProgram, std::vector<int>{-1}).asInt();
+   })};
+   std::cout << "EvaluationFrame on a chain of " << numberInfixes 
+      << " infix expressions: " << infixTime << " ms, and of " << numberIfs 
+      << " if-statements: " << ifTime << " ms" << std::endl;
+   if (infixResult != static_cast<int>(numberInfixes) || ifResult != -1)
+      std::cerr << "Deep trees evaluated wrongly" << std::endl;
+
+   delete infixProgram;
+   delete ifProgram;
+}
+
+//------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+try {
+   // The number of students in the roster that the programs are made for
+   unsigned numberStudents{100};
+   if (argc > 2) throw BadArgument{};
+   if (argc == 2) numberStudents = std::stoi(argv[1]);
+
+   std::vector<Boilerplate*> programs;
+   makeCasesPrograms(numberStudents, programs);
+   benchBytecode(programs);
+   benchDispatch(programs);
+   benchWalker(programs);
+   benchDeepTrees(1000000, 200000);
+   for (Boilerplate* program : programs) delete program;
+}
+catch (BadArgument) {
+   std::cerr << "Unexpected argument found." << std::endl;
+}
+catch (BadSize) {
+   std::cerr << "Range error, or other size error." << std::endl;
+}
+catch (std::exception& e) {
+   std::cerr << e.what() << std::endl;
+}
@@ -0,0 +1,367 @@
+#include "AST.h"
+#include <cstdlib>
+#include <new>
+
+// Checks run by make check. Every evaluator is run on random programs of the
+// kinds the generator makes, and on a few written by hand, and its results are
+// compared with those of ResultFinder, the tree interpreter that the others
+// replace. Printing is checked not to allocate once its buffers have grown, and
+// printing from templates to print what accept() does. A failed check prints
+// what failed and the program, in Java.
+
+static unsigned numberChecks{0};
+static unsigned numberFailures{0};
+
+// Heap allocations made while countingAllocations is set
+static bool countingAllocations{false};
+static unsigned long long numberAllocations{0};
+
+//------------------------------------------------------------------------------------
+
+void* operator new(std::size_t size)
+{
+   if (countingAllocations) ++numberAllocations;
+   if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+   throw std::bad_alloc{};
+}
+
+//------------------------------------------------------------------------------------
+
+void operator delete(void* memory) noexcept
+{
+   std::free(memory);
+}
+
+//------------------------------------------------------------------------------------
+
+static void check(bool passed, const std::string& what, Boilerplate* program)
+{
+   ++numberChecks;
+   if (passed) return;
+   ++numberFailures;
+   std::cerr << "FAILED: " << what << '\n';
+   JavaPrinter printer;
+   printer.setOutStream(std::cerr);
+   program->accept(&printer);
+   printer.flush();
+}
+
+//------------------------------------------------------------------------------------
+
+static std::string argsToString(const std::vector<int>& args)
+{
+   std::string s{"("};
+   for (unsigned i=0; i<args.size(); ++i)
+      s += (i > 0 ? ", " : "") + std::to_string(args.at(i));
+   return s + ")";
+}
+
+//------------------------------------------------------------------------------------
+
+static int findResult(Boilerplate* program, const std::vector<int>& args,
+      const std::vector<std::string>& params)
+{
+   ResultFinder finder{args, params};
+   program->accept(&finder);
+   return finder.getResult();
+}
+
+//------------------------------------------------------------------------------------
+
+// Runs program on each of inputs (one vector of arguments each) with every
+// evaluator, and checks that they all give what ResultFinder does. The
+// recurrence evaluator works in 64 bits, and is compared after wrapping its
+// result around to an int; the decision table only if hasTable.
+static void checkEvaluators(Boilerplate* program,
+      const std::vector<std::string>& params,
+      const std::vector<std::vector<int>>& inputs, bool hasTable)
+{
+   BytecodeCompiler compiler;
+   program->accept(&compiler);
+   BytecodeVM vm;
+   DecisionTable table;
+   check(table.build(program) == hasTable, "DecisionTable::build", program);
+   FlatTree flat{program};
+   Boilerplate* folded{ConstantFolder{}.fold(program)};
+   RecurrenceEvaluator recurrence;
+   EvaluationFrame frame;
+
+   std::vector<std::vector<int>> lanes(params.size(),
+         std::vector<int>(inputs.size()));
+   for (unsigned i=0; i<inputs.size(); ++i)
+      for (unsigned j=0; j<params.size(); ++j)
+         lanes.at(j).at(i) = inputs.at(i).at(j);
+   std::vector<int> batchResults;
+   evaluateBatches(program, lanes, inputs.size(), batchResults);
+
+   for (unsigned i=0; i<inputs.size(); ++i) {
+      const std::vector<int>& args = inputs.at(i);
+      std::string on{" on " + argsToString(args)};
+      int expected{findResult(program, args, params)};
+      check(vm.run(compiler.getBytecode(), args) == expected, "BytecodeVM" + on,
+            program);
+      check(batchResults.at(i) == expected, "BatchEvaluator" + on, program);
+      if (hasTable)
+         check(table.lookup(args) == expected, "DecisionTable" + on, program);
+      std::vector<long long> longArgs{args.begin(), args.end()};
+      check(static_cast<int>(recurrence.evaluate(program, longArgs)) == expected,
+            "RecurrenceEvaluator" + on, program);
+      check(frame.run(program, args).asInt() == expected, "EvaluationFrame" + on,
+            program);
+      check(evaluate(flat, args).asInt() == expected, "FlatTree" + on, program);
+      check(findResult(folded, args, params) == expected, "ConstantFolder" + on,
+            program);
+   }
+   delete folded;
+}
+
+//------------------------------------------------------------------------------------
+
+// A1/A2 programs, on arguments drawn as printA1A2Tests() draws them
+static void checkCasesPrograms(unsigned numberPrograms, unsigned numberInputs)
+{
+   std::vector<std::string> params{"v", "u", "w"};
+   std::vector<Parameter> casesParams;
+   for (const std::string& p : params)
+      casesParams.push_back(Parameter{Type::INT, p});
+   Rand_int rnd{-TEST_RANGE, TEST_RANGE};
+   for (unsigned p=0; p<numberPrograms; ++p) {
+      Boilerplate* program{createCasesProgram("se2s03", "A1", casesParams)};
+      std::vector<std::vector<int>> inputs(numberInputs);
+      for (std::vector<int>& args : inputs)
+         for (unsigned j=0; j<params.size(); ++j) args.push_back(rnd());
+      checkEvaluators(program, params, inputs, true);
+      delete program;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+// A3 programs, for the n that printA3Tests() tests. ResultFinder carries on
+// after a return, so it is only right from n = 1 on.
+static void checkRecurrencePrograms(unsigned numberPrograms)
+{
+   const int MAX_N{18};
+   for (unsigned p=0; p<numberPrograms; ++p) {
+      Block* block{new Block};
+      createRecurrenceBlock(block);
+      Boilerplate* program{createBoilerPlate("se2s03", "A3", block, "rec",
+            std::vector<Parameter>{Parameter{Type::INT, "n"}}, Type::INT)};
+      std::vector<std::vector<int>> inputs;
+      for (int n=1; n<=MAX_N; ++n) inputs.push_back(std::vector<int>{n});
+      checkEvaluators(program, std::vector<std::string>{"n"}, inputs, false);
+      delete program;
+   }
+}
+
+//------------------------------------------------------------------------------------
+
+// int sum = 0; for (int i=0; i<=n; i++) { int square = i*i; sum = sum + square; }
+// return sum; -- the loop body declares a variable on every iteration
+static void checkLoopDeclarations()
+{
+   NodeFactory& nodes = NodeFactory::global();
+   Block* body{new Block};
+   body->addStatement(new VarDeclStatement{std::vector<VarDeclFragment*>{
+      new VarDeclFragment{nodes.name("square"), nodes.infix(nodes.name("i"),
+            InfixOperator::TIMES, nodes.name("i")), Type::INT}}, Type::INT});
+   body->addStatement(new AssignmentStatement{nodes.name("sum"), nodes.infix(
+            nodes.name("sum"), InfixOperator::PLUS, nodes.name("square"))});
+   Block* block{new Block};
+   block->addStatement(new VarDeclStatement{std::vector<VarDeclFragment*>{
+      new VarDeclFragment{nodes.name("sum"), nodes.number(0), Type::INT}},
+      Type::INT});
+   block->addStatement(new ForStatement{std::vector<VarDeclFragment*>{
+      new VarDeclFragment{nodes.name("i"), nodes.number(0), Type::INT}},
+      nodes.infix(nodes.name("i"), InfixOperator::LESS_EQUALS, nodes.name("n")),
+      std::vector<Expression*>{nodes.postfix(nodes.name("i"),
+            PostfixOperator::INCREMENT)}, body});
+   block->addStatement(new ReturnStatement{nodes.name("sum")});
+   Boilerplate* program{createBoilerPlate("se2s03", "Squares", block, "squares",
+         std::vector<Parameter>{Parameter{Type::INT, "n"}}, Type::INT)};
+
+   std::vector<int> n;
+   for (int i=-1; i<=20; ++i) n.push_back(i);
+   std::vector<int> results;
+   evaluateBatches(program, std::vector<std::vector<int>>{n}, n.size(), results);
+   BytecodeCompiler compiler;
+   program->accept(&compiler);
+   BytecodeVM vm;
+   for (unsigned i=0; i<n.size(); ++i) {
+      std::vector<int> args{n.at(i)};
+      std::string on{" on " + argsToString(args)};
+      int expected{findResult(program, args, std::vector<std::string>{"n"})};
+      int squares{n.at(i) < 0 ? 0 : n.at(i) * (n.at(i) + 1) * (2 * n.at(i) + 1) / 6};
+      check(expected == squares, "ResultFinder" + on, program);
+      check(results.at(i) == expected, "BatchEvaluator" + on, program);
+      check(vm.run(compiler.getBytecode(), args) == expected, "BytecodeVM" + on,
+            program);
+   }
+   delete program;
+}
+
+//------------------------------------------------------------------------------------
+
+// Prints an A1 program and its tester of 205 asserts with printer, twice, and
+// checks that the second time makes no heap allocations: the printer's sink has
+// grown to fit them the first time, and nothing else is allocated.
+static void checkPrintingAllocations(Printer& printer, const std::string& language)
+{
+   const unsigned NUMBER_TESTS{205};
+   std::vector<std::string> params{"v", "u", "w"};
+   std::vector<Parameter> casesParams;
+   for (const std::string& p : params)
+      casesParams.push_back(Parameter{Type::INT, p});
+   Boilerplate* program{createCasesProgram("se2s03", "A1", casesParams)};
+   TesterBoilerplate tester{"se2s03", "A1", "cases", "A1Test", 3};
+   Rand_int rnd{-TEST_RANGE, TEST_RANGE};
+   for (unsigned i=0; i<NUMBER_TESTS; ++i) {
+      std::vector<int> args{rnd(), rnd(), rnd()};
+      tester.getAsserts().add(args.data(), findResult(program, args, params));
+   }
+
+   std::ofstream devNull{"/dev/null"};
+   printer.setOutStream(devNull);
+   for (int round=0; round<2; ++round) {
+      numberAllocations = 0;
+      countingAllocations = round == 1;
+      program->accept(&printer);
+      printer.flush();
+      tester.accept(&printer);
+      printer.flush();
+      countingAllocations = false;
+   }
+   check(numberAllocations == 0, std::to_string(numberAllocations) + 
+         " allocations printing in " + language, program);
+   printer.setOutStream(std::cout);
+   delete program;
+}
+
+//------------------------------------------------------------------------------------
+
+static std::string printed(Printer& printer, Boilerplate* program, bool byTemplate)
+{
+   OutputSink sink;
+   printer.setOutStream(sink);
+   if (byTemplate) printer.printByTemplate(program);
+   else program->accept(&printer);
+   printer.setOutStream(std::cout);
+   return sink.getBuffer();
+}
+
+//------------------------------------------------------------------------------------
+
+// Checks that printing program from a template prints what accept() does, and
+// then that a copy of it whose literals are all equal, so that ExpressionDag
+// merges them, prints from the same template what accept() does
+static void checkTemplate(Printer& printer, const std::string& language,
+      Boilerplate* program)
+{
+   check(printed(printer, program, true) == printed(printer, program, false),
+         "Template in " + language, program);
+   Boilerplate* copy{FlatTree{program}.toAST()};
+   ProgramShape shape{copy};
+   for (NumberLiteral* numberLiteral : shape.getLiterals())
+      numberLiteral->setValue(2);
+   check(printed(printer, copy, true) == printed(printer, copy, false),
+         "Template of equal literals in " + language, copy);
+   delete copy;
+}
+
+//------------------------------------------------------------------------------------
+
+// int a = 0, b = 0; for (int i=0; i<=n; i++) { a = a + n*2; b = b + n*3; }
+// return a; -- printed in Haskell with n*2 bound once if the literals are equal
+static Boilerplate* createLiteralLoopProgram()
+{
+   NodeFactory& nodes = NodeFactory::global();
+   Block* body{new Block};
+   body->addStatement(new AssignmentStatement{nodes.name("a"), nodes.infix(
+            nodes.name("a"), InfixOperator::PLUS, nodes.infix(nodes.name("n"),
+               InfixOperator::TIMES, nodes.number(2)))});
+   body->addStatement(new AssignmentStatement{nodes.name("b"), nodes.infix(
+            nodes.name("b"), InfixOperator::PLUS, nodes.infix(nodes.name("n"),
+               InfixOperator::TIMES, nodes.number(3)))});
+   Block* block{new Block};
+   block->addStatement(new VarDeclStatement{std::vector<VarDeclFragment*>{
+      new VarDeclFragment{nodes.name("a"), nodes.number(0), Type::INT},
+      new VarDeclFragment{nodes.name("b"), nodes.number(0), Type::INT}},
+      Type::INT});
+   block->addStatement(new ForStatement{std::vector<VarDeclFragment*>{
+      new VarDeclFragment{nodes.name("i"), nodes.number(0), Type::INT}},
+      nodes.infix(nodes.name("i"), InfixOperator::LESS_EQUALS, nodes.name("n")),
+      std::vector<Expression*>{nodes.postfix(nodes.name("i"),
+            PostfixOperator::INCREMENT)}, body});
+   block->addStatement(new ReturnStatement{nodes.name("a")});
+   return createBoilerPlate("se2s03", "Loop", block, "loop",
+         std::vector<Parameter>{Parameter{Type::INT, "n"}}, Type::INT);
+}
+
+//------------------------------------------------------------------------------------
+
+// Templates of A1/A2 and A3 programs, and of a loop holding literals, in every
+// language
+static void checkTemplates(unsigned numberPrograms)
+{
+   JavaPrinter javaPrinter;
+   JavaScriptPrinter jsPrinter;
+   SchemePrinter scmPrinter;
+   HaskellPrinter haskellPrinter;
+   std::vector<std::pair<Printer*, std::string>> printers{{&javaPrinter, "Java"},
+      {&jsPrinter, "JavaScript"}, {&scmPrinter, "Scheme"},
+      {&haskellPrinter, "Haskell"}};
+
+   std::vector<Boilerplate*> programs{createLiteralLoopProgram()};
+   std::vector<Parameter> casesParams{Parameter{Type::INT, "v"},
+      Parameter{Type::INT, "u"}, Parameter{Type::INT, "w"}};
+   for (unsigned p=0; p<numberPrograms; ++p) {
+      programs.push_back(createCasesProgram("se2s03", "A1", casesParams));
+      Block* block{new Block};
+      createRecurrenceBlock(block);
+      programs.push_back(createBoilerPlate("se2s03", "A3", block, "rec",
+            std::vector<Parameter>{Parameter{Type::INT, "n"}}, Type::INT));
+   }
+   for (const std::pair<Printer*, std::string>& printer : printers)
+      for (Boilerplate* program : programs)
+         checkTemplate(*printer.first, printer.second, program);
+   for (Boilerplate* program : programs) delete program;
+}
+
+//------------------------------------------------------------------------------------
+
+int main()
+try {
+   checkCasesPrograms(200, 64);
+   checkRecurrencePrograms(50);
+   checkLoopDeclarations();
+   checkTemplates(50);
+
+   JavaPrinter javaPrinter;
+   JavaScriptPrinter jsPrinter;
+   SchemePrinter scmPrinter;
+   HaskellPrinter haskellPrinter;
+   checkPrintingAllocations(javaPrinter, "Java");
+   checkPrintingAllocations(jsPrinter, "JavaScript");
+   checkPrintingAllocations(scmPrinter, "Scheme");
+   checkPrintingAllocations(haskellPrinter, "Haskell");
+
+   std::cout << numberChecks - numberFailures << " of " << numberChecks
+      << " checks passed" << std::endl;
+   return numberFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch (BadArgument) {
+   std::cerr << "Unexpected argument found." << std::endl;
+   return EXIT_FAILURE;
+}
+catch (BadSize) {
+   std::cerr << "Range error, or other size error." << std::endl;
+   return EXIT_FAILURE;
+}
+catch (BadPath) {
+   std::cerr << "Path error." << std::endl;
+   return EXIT_FAILURE;
+}
+catch (std::exception& e) {
+   std::cerr << e.what() << std::endl;
+   return EXIT_FAILURE;
+}
@@ -1,8 +1,20 @@
 #include "AST.h"
 #include <cstdlib>
 
-int main()
+// With --stats, how much sharing, arena memory and printing there was is
+// written to std::clog at the end. With --program-files dir, each program and
+// its tests are also written to a .ast file under dir (see keepProgramFile()).
+int main(int argc, char* argv[])
 try {
+   bool printStats{false};
+   for (int i=1; i<argc; ++i) {
+      std::string option{argv[i]};
+      if (option == "--stats") printStats = true;
+      else if (option == "--program-files" && i + 1 < argc) 
+         setProgramFileDirectory(argv[++i]);
+      else throw BadArgument{};
+   }
+
    std::string studentNumberFile{"STUDENT_NUMBERS"};
    std::vector<std::string> studentNumbers;
    readStudentNumbers(studentNumberFile, studentNumbers);
@@ -13,17 +25,34 @@ try {
    SchemePrinter myScmPrinter;
    HaskellPrinter myHaskellPrinter;
    for (const std::string& s : studentNumbers) {
-      printA1A2(&myJavaPrinter, s, "Java");
-      printA3(&myJavaPrinter, s, "Java");
+      printA1A2<Java>(&myJavaPrinter, s);
+      printA3<Java>(&myJavaPrinter, s);
 
-      printA1A2(&myJsPrinter, s, "JavaScript");
-      printA3(&myJsPrinter, s, "JavaScript");
+      printA1A2<JavaScript>(&myJsPrinter, s);
+      printA3<JavaScript>(&myJsPrinter, s);
 
-      printA1A2(&myScmPrinter, s, "Scheme");
-      printA3(&myScmPrinter, s, "Scheme");
+      printA1A2<Scheme>(&myScmPrinter, s);
+      printA3<Scheme>(&myScmPrinter, s);
+
+      printA1A2<Haskell>(&myHaskellPrinter, s);
+      printA3<Haskell>(&myHaskellPrinter, s);
+   }
 
-      printA1A2(&myHaskellPrinter, s, "Haskell");
-      printA3(&myHaskellPrinter, s, "Haskell");
+   if (printStats) {
+      const NodeFactory& nodes = NodeFactory::global();
+      std::clog << "Shared expressions: " << nodes.numberNodes() << " nodes ("
+         << nodes.numberBytes() << " bytes) made for " << nodes.numberRequests()
+         << " asked for (" << nodes.numberRequestedBytes() << " bytes)" 
+         << std::endl;
+      unsigned long long programs{NodeArena::totalPrograms()};
+      if (programs > 0)
+         std::clog << "Program arenas: " << programs << " programs of " 
+            << NodeArena::totalNodes() / programs << " nodes (" 
+            << NodeArena::totalBytes() / programs << " bytes) on average, "
+            << "the largest " << NodeArena::largestProgram() << " bytes" 
+            << std::endl;
+      std::clog << "Output: " << OutputSink::totalBytes() << " bytes in " 
+         << OutputSink::totalFlushes() << " writes" << std::endl;
    }
 }
 catch (BadArgument) {